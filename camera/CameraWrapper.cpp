@@ -28,6 +28,7 @@
 
 #include <utils/threads.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
 #include <hardware/hardware.h>
 #include <hardware/camera.h>
 #include <camera/Camera.h>
@@ -111,14 +112,127 @@ static int get_product_device()
     return product_device;
 }
 
+#define MAX_PARAM_OVERRIDES 16
+
+typedef struct param_override {
+    const char *key;
+    const char *value;
+} param_override_t;
+
+typedef struct param_overrides {
+    int count;
+    param_override_t entries[MAX_PARAM_OVERRIDES];
+} param_overrides_t;
+
+/* every vendor op forwarded through VENDOR_CALL */
+#define CAMERA_OPS(OP) \
+    OP(set_preview_window) \
+    OP(set_callbacks) \
+    OP(enable_msg_type) \
+    OP(disable_msg_type) \
+    OP(msg_type_enabled) \
+    OP(start_preview) \
+    OP(stop_preview) \
+    OP(preview_enabled) \
+    OP(store_meta_data_in_buffers) \
+    OP(start_recording) \
+    OP(stop_recording) \
+    OP(recording_enabled) \
+    OP(release_recording_frame) \
+    OP(auto_focus) \
+    OP(cancel_auto_focus) \
+    OP(take_picture) \
+    OP(cancel_picture) \
+    OP(set_parameters) \
+    OP(get_parameters) \
+    OP(put_parameters) \
+    OP(send_command) \
+    OP(release) \
+    OP(dump)
+
+#define CAMERA_OP_ENUM(name) CAMERA_OP_ ## name,
+#define CAMERA_OP_NAME(name) #name,
+
+enum {
+    CAMERA_OPS(CAMERA_OP_ENUM)
+    CAMERA_OP_MAX
+};
+
+static const char *camera_op_names[CAMERA_OP_MAX] = {
+    CAMERA_OPS(CAMERA_OP_NAME)
+};
+
+/* latency buckets are powers of two in microseconds: [2^(n-1), 2^n) */
+#define LATENCY_BUCKETS 32
+
+/* all fields are updated with relaxed atomics, never under a lock */
+typedef struct camera_op_stats {
+    uint32_t count;
+    uint32_t in_flight;
+    uint32_t max_us;
+    uint64_t total_us;
+    int64_t last_start_ns;
+    uint32_t buckets[LATENCY_BUCKETS];
+} camera_op_stats_t;
+
 typedef struct wrapper_camera_device {
     camera_device_t base;
     int id;
     camera_device_t *vendor;
+
+    /* guards the parameter caches below */
+    pthread_mutex_t params_lock;
+    /* static supported-value overrides for get_parameters, built at open */
+    param_overrides_t get_overrides;
+    /* last vendor get_parameters string, its fixed-up result and the
+     * video-hfr value it was fixed up with */
+    char *vendor_get_params;
+    char *fixed_get_params;
+    char fixed_get_hfr[sizeof(videoHfr)];
+    /* last set_parameters string passed in by the framework */
+    char *last_set_params;
+
+    camera_op_stats_t stats[CAMERA_OP_MAX];
 } wrapper_camera_device_t;
 
+class CameraOpTimer {
+public:
+    CameraOpTimer(camera_op_stats_t *stats)
+        : mStats(stats), mStart(systemTime(SYSTEM_TIME_MONOTONIC))
+    {
+        __atomic_fetch_add(&mStats->in_flight, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&mStats->last_start_ns, mStart, __ATOMIC_RELAXED);
+    }
+
+    ~CameraOpTimer()
+    {
+        nsecs_t us = (systemTime(SYSTEM_TIME_MONOTONIC) - mStart) / 1000;
+        uint32_t val = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+        int bucket = val ? 32 - __builtin_clz(val) : 0;
+        uint32_t max;
+
+        if (bucket >= LATENCY_BUCKETS)
+            bucket = LATENCY_BUCKETS - 1;
+
+        __atomic_fetch_add(&mStats->buckets[bucket], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&mStats->total_us, val, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&mStats->count, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&mStats->in_flight, 1, __ATOMIC_RELAXED);
+
+        max = __atomic_load_n(&mStats->max_us, __ATOMIC_RELAXED);
+        while (val > max && !__atomic_compare_exchange_n(&mStats->max_us,
+                &max, val, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            ;
+    }
+
+private:
+    camera_op_stats_t *mStats;
+    nsecs_t mStart;
+};
+
 #define VENDOR_CALL(device, func, ...) ({ \
     wrapper_camera_device_t *__wrapper_dev = (wrapper_camera_device_t*) device; \
+    CameraOpTimer __timer(&__wrapper_dev->stats[CAMERA_OP_ ## func]); \
     __wrapper_dev->vendor->ops->func(__wrapper_dev->vendor, ##__VA_ARGS__); \
 })
 
@@ -139,63 +253,219 @@ static int check_vendor_module()
     return rv;
 }
 
-static char *camera_fixup_getparams(int id, const char *settings)
+static void camera_add_override(param_overrides_t *overrides,
+        const char *key, const char *value)
 {
-    CameraParameters params;
-    params.unflatten(String8(settings));
+    for (int i = 0; i < overrides->count; i++) {
+        if (!strcmp(overrides->entries[i].key, key)) {
+            overrides->entries[i].value = value;
+            return;
+        }
+    }
 
-#if !LOG_NDEBUG
-    ALOGV("%s: original parameters:", __FUNCTION__);
-    params.dump();
-#endif
+    if (overrides->count >= MAX_PARAM_OVERRIDES) {
+        ALOGE("%s: too many overrides, dropping %s", __FUNCTION__, key);
+        return;
+    }
+
+    overrides->entries[overrides->count].key = key;
+    overrides->entries[overrides->count].value = value;
+    overrides->count++;
+}
+
+static void camera_init_getparams_overrides(int id,
+        param_overrides_t *overrides)
+{
+    overrides->count = 0;
 
     if (id == BACK_CAMERA) {
-        params.set(CameraParameters::KEY_SUPPORTED_FLASH_MODES, "auto,on,off,torch");
+        camera_add_override(overrides,
+                CameraParameters::KEY_SUPPORTED_FLASH_MODES, "auto,on,off,torch");
     }
 
-    params.set(CameraParameters::KEY_QC_SUPPORTED_DENOISE, "denoise-on,denoise-off");
-    params.set(CameraParameters::KEY_QC_SUPPORTED_FACE_DETECTION, "on,off");
-    params.set(CameraParameters::KEY_QC_SUPPORTED_REDEYE_REDUCTION, "enable,disable");
+    camera_add_override(overrides,
+            CameraParameters::KEY_QC_SUPPORTED_DENOISE, "denoise-on,denoise-off");
+    camera_add_override(overrides,
+            CameraParameters::KEY_QC_SUPPORTED_FACE_DETECTION, "on,off");
+    camera_add_override(overrides,
+            CameraParameters::KEY_QC_SUPPORTED_REDEYE_REDUCTION, "enable,disable");
 
     if (get_product_device() == FALCON || get_product_device() == PEREGRINE) {
         if (id == BACK_CAMERA) {
-            params.set(CameraParameters::KEY_QC_SUPPORTED_HFR_SIZES, "1296x728");
-            params.set(CameraParameters::KEY_QC_SUPPORTED_VIDEO_HIGH_FRAME_RATE_MODES, "60,off");
+            camera_add_override(overrides,
+                    CameraParameters::KEY_QC_SUPPORTED_HFR_SIZES, "1296x728");
+            camera_add_override(overrides,
+                    CameraParameters::KEY_QC_SUPPORTED_VIDEO_HIGH_FRAME_RATE_MODES, "60,off");
         }
     } else {
-        params.set(CameraParameters::KEY_QC_SUPPORTED_HFR_SIZES, "1296x728,1296x728,720x480");
-        params.set(CameraParameters::KEY_QC_SUPPORTED_VIDEO_HIGH_FRAME_RATE_MODES, "60,90,120,off");
-        params.set(CameraParameters::KEY_QC_SUPPORTED_ZSL_MODES, "on,off");
+        camera_add_override(overrides,
+                CameraParameters::KEY_QC_SUPPORTED_HFR_SIZES, "1296x728,1296x728,720x480");
+        camera_add_override(overrides,
+                CameraParameters::KEY_QC_SUPPORTED_VIDEO_HIGH_FRAME_RATE_MODES, "60,90,120,off");
+        camera_add_override(overrides,
+                CameraParameters::KEY_QC_SUPPORTED_ZSL_MODES, "on,off");
     }
 
     if (!(get_product_device() == FALCON || get_product_device() == PEREGRINE) ||
             id == BACK_CAMERA) {
-        params.set(CameraParameters::KEY_QC_SUPPORTED_TOUCH_AF_AEC, "touch-on,touch-off");
-        params.set(CameraParameters::KEY_SUPPORTED_SCENE_MODES,
+        camera_add_override(overrides,
+                CameraParameters::KEY_QC_SUPPORTED_TOUCH_AF_AEC, "touch-on,touch-off");
+        camera_add_override(overrides,
+                CameraParameters::KEY_SUPPORTED_SCENE_MODES,
                 "auto,action,portrait,landscape,night,night-portrait,theatre"
                 "candlelight,beach,snow,sunset,steadyphoto,fireworks,sports,party,"
                 "auto_hdr,hdr,asd,backlight,flowers,AR");
     }
+}
+
+static inline const char *camera_param_end(const char *a)
+{
+    const char *b = strchr(a, ';');
+    return b ? b : a + strlen(a);
+}
+
+/*
+ * Find the value of key in a flattened "k1=v1;k2=v2" parameter string.
+ * Returns a pointer into settings and stores the value length in len.
+ */
+static const char *camera_find_param(const char *settings, const char *key,
+        size_t *len)
+{
+    size_t klen = strlen(key);
+    const char *a = settings;
+
+    while (*a) {
+        const char *b = camera_param_end(a);
+        if ((size_t)(b - a) > klen && a[klen] == '=' && !strncmp(a, key, klen)) {
+            *len = b - (a + klen + 1);
+            return a + klen + 1;
+        }
+        a = *b ? b + 1 : b;
+    }
+
+    return NULL;
+}
+
+/*
+ * Replace the values of the given keys in a flattened parameter string and
+ * append the keys that are missing, without building a CameraParameters map.
+ * Segments without '=' are dropped, as CameraParameters::unflatten does.
+ */
+static char *camera_splice_params(const char *settings,
+        const param_override_t *entries, int count)
+{
+    String8 out;
+    bool used[MAX_PARAM_OVERRIDES + 1];
+    const char *a = settings;
+
+    memset(used, 0, sizeof(used));
+
+    while (*a) {
+        const char *b = camera_param_end(a);
+        const char *eq = (const char *)memchr(a, '=', b - a);
+
+        if (eq) {
+            size_t klen = eq - a;
+            int i;
+
+            for (i = 0; i < count; i++) {
+                if (strlen(entries[i].key) == klen &&
+                        !strncmp(entries[i].key, a, klen))
+                    break;
+            }
+
+            if (out.length())
+                out.append(";");
+            if (i < count) {
+                out.append(entries[i].key);
+                out.append("=");
+                out.append(entries[i].value);
+                used[i] = true;
+            } else {
+                out.append(a, b - a);
+            }
+        }
+
+        a = *b ? b + 1 : b;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (used[i])
+            continue;
+        if (out.length())
+            out.append(";");
+        out.append(entries[i].key);
+        out.append("=");
+        out.append(entries[i].value);
+    }
+
+    return strdup(out.string());
+}
+
+static char *camera_fixup_getparams(wrapper_camera_device_t *dev,
+        const char *settings)
+{
+    param_override_t entries[MAX_PARAM_OVERRIDES + 1];
+    int count = dev->get_overrides.count;
+    char *ret;
+
+    pthread_mutex_lock(&dev->params_lock);
+
+    if (dev->vendor_get_params && dev->fixed_get_params &&
+            !strcmp(dev->fixed_get_hfr, videoHfr) &&
+            !strcmp(dev->vendor_get_params, settings)) {
+        ret = strdup(dev->fixed_get_params);
+        pthread_mutex_unlock(&dev->params_lock);
+        return ret;
+    }
+
+#if !LOG_NDEBUG
+    ALOGV("%s: original parameters:", __FUNCTION__);
+    CameraParameters(String8(settings)).dump();
+#endif
+
+    memcpy(entries, dev->get_overrides.entries, sizeof(entries[0]) * count);
 
     /* HFR video recording workaround */
-    const char *recordingHint = params.get(CameraParameters::KEY_RECORDING_HINT);
-    if (recordingHint && !strcmp(recordingHint, "true")) {
-        params.set(CameraParameters::KEY_QC_VIDEO_HIGH_FRAME_RATE, videoHfr);
+    size_t len;
+    const char *recordingHint = camera_find_param(settings,
+            CameraParameters::KEY_RECORDING_HINT, &len);
+    if (recordingHint && len == 4 && !strncmp(recordingHint, "true", 4) &&
+            !strpbrk(videoHfr, "=;")) {
+        entries[count].key = CameraParameters::KEY_QC_VIDEO_HIGH_FRAME_RATE;
+        entries[count].value = videoHfr;
+        count++;
     }
 
+    char *fixed = camera_splice_params(settings, entries, count);
+
 #if !LOG_NDEBUG
     ALOGV("%s: fixed parameters:", __FUNCTION__);
-    params.dump();
+    CameraParameters(String8(fixed)).dump();
 #endif
 
-    String8 strParams = params.flatten();
-    char *ret = strdup(strParams.string());
+    free(dev->vendor_get_params);
+    free(dev->fixed_get_params);
+    dev->vendor_get_params = strdup(settings);
+    dev->fixed_get_params = fixed;
+    snprintf(dev->fixed_get_hfr, sizeof(dev->fixed_get_hfr), "%s", videoHfr);
+
+    ret = fixed ? strdup(fixed) : NULL;
+    pthread_mutex_unlock(&dev->params_lock);
 
     return ret;
 }
 
-static char *camera_fixup_setparams(int id, const char *settings)
+static char *camera_fixup_setparams(wrapper_camera_device_t *dev,
+        const char *settings)
 {
+    int id = dev->id;
+
+    /* the framework often re-applies an unchanged string */
+    if (dev->last_set_params && fixed_set_params[id] &&
+            !strcmp(dev->last_set_params, settings))
+        return fixed_set_params[id];
+
     CameraParameters params;
     params.unflatten(String8(settings));
 
@@ -232,6 +502,9 @@ static char *camera_fixup_setparams(int id, const char *settings)
     fixed_set_params[id] = strdup(strParams.string());
     char *ret = fixed_set_params[id];
 
+    free(dev->last_set_params);
+    dev->last_set_params = strdup(settings);
+
     return ret;
 }
 
@@ -447,10 +720,13 @@ static int camera_set_parameters(struct camera_device *device,
     if (!device)
         return -EINVAL;
 
-    char *tmp = NULL;
-    tmp = camera_fixup_setparams(CAMERA_ID(device), params);
+    wrapper_camera_device_t *wrapper_dev = (wrapper_camera_device_t*) device;
 
+    pthread_mutex_lock(&wrapper_dev->params_lock);
+    char *tmp = camera_fixup_setparams(wrapper_dev, params);
     int ret = VENDOR_CALL(device, set_parameters, tmp);
+    pthread_mutex_unlock(&wrapper_dev->params_lock);
+
     return ret;
 }
 
@@ -464,7 +740,8 @@ static char *camera_get_parameters(struct camera_device *device)
 
     char *params = VENDOR_CALL(device, get_parameters);
 
-    char *tmp = camera_fixup_getparams(CAMERA_ID(device), params);
+    char *tmp = camera_fixup_getparams((wrapper_camera_device_t*) device,
+            params);
     VENDOR_CALL(device, put_parameters, params);
     params = tmp;
     return params;
@@ -502,6 +779,60 @@ static void camera_release(struct camera_device *device)
     VENDOR_CALL(device, release);
 }
 
+/* upper bound in us of the bucket holding the given percentile */
+static uint32_t camera_stats_percentile(const uint32_t *buckets,
+        uint32_t count, int percent)
+{
+    uint64_t target = ((uint64_t)count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target && seen)
+            return i ? (1u << i) - 1 : 0;
+    }
+
+    return UINT32_MAX;
+}
+
+static void camera_dump_stats(wrapper_camera_device_t *dev, int fd)
+{
+    nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    dprintf(fd, "CameraWrapper vendor call latency, camera %d (us):\n", dev->id);
+    dprintf(fd, "  %-28s %8s %8s %8s %8s %8s %s\n",
+            "op", "count", "avg", "p50<=", "p99<=", "max", "in-flight");
+
+    for (int op = 0; op < CAMERA_OP_MAX; op++) {
+        camera_op_stats_t *stats = &dev->stats[op];
+        uint32_t buckets[LATENCY_BUCKETS];
+        uint32_t count = __atomic_load_n(&stats->count, __ATOMIC_RELAXED);
+        uint32_t in_flight = __atomic_load_n(&stats->in_flight, __ATOMIC_RELAXED);
+
+        if (!count && !in_flight)
+            continue;
+
+        for (int i = 0; i < LATENCY_BUCKETS; i++)
+            buckets[i] = __atomic_load_n(&stats->buckets[i], __ATOMIC_RELAXED);
+
+        uint64_t total = __atomic_load_n(&stats->total_us, __ATOMIC_RELAXED);
+        uint32_t max = __atomic_load_n(&stats->max_us, __ATOMIC_RELAXED);
+
+        dprintf(fd, "  %-28s %8u %8llu %8u %8u %8u %u",
+                camera_op_names[op], count,
+                (unsigned long long)(count ? total / count : 0),
+                camera_stats_percentile(buckets, count, 50),
+                camera_stats_percentile(buckets, count, 99),
+                max, in_flight);
+        if (in_flight) {
+            int64_t start = __atomic_load_n(&stats->last_start_ns, __ATOMIC_RELAXED);
+            dprintf(fd, " (latest running %lld us)",
+                    (long long)((now - start) / 1000));
+        }
+        dprintf(fd, "\n");
+    }
+}
+
 static int camera_dump(struct camera_device *device, int fd)
 {
     ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
@@ -510,6 +841,8 @@ static int camera_dump(struct camera_device *device, int fd)
     if (!device)
         return -EINVAL;
 
+    camera_dump_stats((wrapper_camera_device_t*) device, fd);
+
     return VENDOR_CALL(device, dump, fd);
 }
 
@@ -529,14 +862,19 @@ static int camera_device_close(hw_device_t *device)
         goto done;
     }
 
-    for (int i = 0; i < camera_get_number_of_cameras(); i++) {
-        if (fixed_set_params[i])
-            free(fixed_set_params[i]);
-    }
-
     wrapper_dev = (wrapper_camera_device_t*) device;
 
+    /* only drop our own entry, the other cameras may still be open */
+    if (fixed_set_params[wrapper_dev->id]) {
+        free(fixed_set_params[wrapper_dev->id]);
+        fixed_set_params[wrapper_dev->id] = NULL;
+    }
+
     wrapper_dev->vendor->common.close((hw_device_t*)wrapper_dev->vendor);
+    free(wrapper_dev->vendor_get_params);
+    free(wrapper_dev->fixed_get_params);
+    free(wrapper_dev->last_set_params);
+    pthread_mutex_destroy(&wrapper_dev->params_lock);
     if (wrapper_dev->base.ops)
         free(wrapper_dev->base.ops);
     free(wrapper_dev);
@@ -601,6 +939,8 @@ static int camera_device_open(const hw_module_t *module, const char *name,
         }
         memset(camera_device, 0, sizeof(*camera_device));
         camera_device->id = cameraid;
+        pthread_mutex_init(&camera_device->params_lock, NULL);
+        camera_init_getparams_overrides(cameraid, &camera_device->get_overrides);
 
         int retries = OPEN_RETRIES;
         bool retry;
@@ -31,6 +31,7 @@
 
 #include <dlfcn.h>
 #include <cutils/sched_policy.h>
+#include <cutils/properties.h>
 #include <unistd.h>
 #include <ContextBase.h>
 #include <msg_q.h>
@@ -78,6 +79,20 @@ LocApiBase* ContextBase::createLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask)
     }
 
     // locApi could still be NULL at this time
+    // try the fake one, only when asked for, on builds meant for testing
+    char fakeProp[PROPERTY_VALUE_MAX];
+    property_get("debug.gps.fake_loc_api", fakeProp, "0");
+    if (NULL == locApi && 0 == strcmp(fakeProp, "1")) {
+        void* handle = dlopen("libloc_api_fake.so", RTLD_NOW);
+        if (NULL != handle) {
+            getLocApi_t* getter = (getLocApi_t*)dlsym(handle, "getLocApi");
+            if (NULL != getter) {
+                LOC_LOGD("%s:%d]: using the fake LocApi\n", __func__, __LINE__);
+                locApi = (*getter)(mMsgTask, exMask);
+            }
+        }
+    }
+
     // we would then create a dummy one
     if (NULL == locApi) {
         locApi = new LocApiBase(mMsgTask, exMask);
@@ -86,14 +101,98 @@ LocApiBase* ContextBase::createLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask)
     return locApi;
 }
 
+struct ContextBase::BringUpMsg : public LocMsg {
+    ContextBase* mContext;
+    inline BringUpMsg(ContextBase* context) :
+        LocMsg(), mContext(context)
+    {
+        locallog();
+    }
+    inline virtual void proc() const {
+        mContext->waitReady();
+
+        pthread_mutex_lock(&mContext->mReadyLock);
+        mContext->mBringUpMsgDone = true;
+        pthread_cond_broadcast(&mContext->mReadyCond);
+        pthread_mutex_unlock(&mContext->mReadyLock);
+    }
+    inline void locallog() const {
+        LOC_LOGV("ContextBase bring up, exMask: %x, lib: %s",
+                 (unsigned int)mContext->mExMask, mContext->mLibName);
+    }
+    inline virtual void log() const {
+        locallog();
+    }
+};
+
+void ContextBase::bringUp()
+{
+    mLBSProxy = getLBSProxy(mLibName);
+    mLocApi = createLocApi(mExMask);
+    mLocApiProxy = mLocApi->getLocApiProxy();
+    LOC_LOGD("%s:%d]: LocApi %p ready\n", __func__, __LINE__, mLocApi);
+}
+
+void ContextBase::waitReady()
+{
+    pthread_mutex_lock(&mReadyLock);
+    if (!mReady && !mBringingUp) {
+        // first to get here, the message or an early caller
+        mBringingUp = true;
+        pthread_mutex_unlock(&mReadyLock);
+
+        bringUp();
+
+        pthread_mutex_lock(&mReadyLock);
+        mReady = true;
+        pthread_cond_broadcast(&mReadyCond);
+    }
+    while (!mReady) {
+        pthread_cond_wait(&mReadyCond, &mReadyLock);
+    }
+    pthread_mutex_unlock(&mReadyLock);
+}
+
 ContextBase::ContextBase(const MsgTask* msgTask,
                          LOC_API_ADAPTER_EVENT_MASK_T exMask,
                          const char* libName) :
-    mLBSProxy(getLBSProxy(libName)),
+    mLBSProxy(NULL),
     mMsgTask(msgTask),
-    mLocApi(createLocApi(exMask)),
-    mLocApiProxy(mLocApi->getLocApiProxy())
+    mLocApi(NULL),
+    mLocApiProxy(NULL),
+    mExMask(exMask),
+    mLibName(libName),
+    mBringingUp(false),
+    mReady(false),
+    mBringUpMsgDone(false)
 {
+    pthread_mutex_init(&mReadyLock, NULL);
+    pthread_cond_init(&mReadyCond, NULL);
+    if (mMsgTask->isTaskThread()) {
+        // created from a message, as the background context usually is;
+        // nothing else can run on this thread until we are up, so the
+        // load costs the same here and no message sees a NULL LocApi
+        bringUp();
+        mReady = true;
+        mBringUpMsgDone = true;
+    } else {
+        // msg_q is FIFO, every message sent after this one sees the LocApi
+        mMsgTask->sendMsg(new BringUpMsg(this));
+    }
+}
+
+ContextBase::~ContextBase()
+{
+    pthread_mutex_lock(&mReadyLock);
+    while (!mBringUpMsgDone) {
+        pthread_cond_wait(&mReadyCond, &mReadyLock);
+    }
+    pthread_mutex_unlock(&mReadyLock);
+
+    delete mLocApi;
+    delete mLBSProxy;
+    pthread_cond_destroy(&mReadyCond);
+    pthread_mutex_destroy(&mReadyLock);
 }
 
 }
@@ -31,6 +31,7 @@
 
 #include <stdbool.h>
 #include <ctype.h>
+#include <pthread.h>
 #include <MsgTask.h>
 #include <LocApiBase.h>
 #include <LBSProxyBase.h>
@@ -40,8 +41,10 @@ namespace loc_core {
 class LocAdapterBase;
 
 class ContextBase {
+    struct BringUpMsg;
     static LBSProxyBase* getLBSProxy(const char* libName);
     LocApiBase* createLocApi(LOC_API_ADAPTER_EVENT_MASK_T excludedMask);
+    void bringUp();
 protected:
     const LBSProxyBase* mLBSProxy;
     const MsgTask* mMsgTask;
@@ -51,17 +54,43 @@ public:
     ContextBase(const MsgTask* msgTask,
                 LOC_API_ADAPTER_EVENT_MASK_T exMask,
                 const char* libName);
-    inline virtual ~ContextBase() { delete mLocApi; delete mLBSProxy; }
+    virtual ~ContextBase();
+
+    // The LBS proxy and the LocApi are loaded by the first message on
+    // the MsgTask, so the opener of the HAL does not wait for dlopen; a
+    // context created on its MsgTask thread loads them in the constructor.
+    // Every getter waits for them; a caller which gets there before the
+    // message, on any thread, loads them itself. Prebuilt libraries carry
+    // older copies of the getters that do not wait: they are only safe on
+    // the MsgTask thread, in messages sent to this context, which always
+    // come after the bring up; anything else must call waitReady() first.
+    void waitReady();
 
     inline const MsgTask* getMsgTask() { return mMsgTask; }
-    inline LocApiBase* getLocApi() { return mLocApi; }
-    inline LocApiProxyBase* getLocApiProxy() { return mLocApiProxy; }
-    inline bool hasAgpsExt() { return mLBSProxy->hasAgpsExt(); }
-    inline bool hasCPIExt() { return mLBSProxy->hasCPIExt(); }
+    inline LocApiBase* getLocApi() { waitReady(); return mLocApi; }
+    inline LocApiProxyBase* getLocApiProxy() {
+        waitReady();
+        return mLocApiProxy;
+    }
+    inline bool hasAgpsExt() { waitReady(); return mLBSProxy->hasAgpsExt(); }
+    inline bool hasCPIExt() { waitReady(); return mLBSProxy->hasCPIExt(); }
     inline void requestUlp(LocAdapterBase* adapter,
                            unsigned long capabilities) {
+        waitReady();
         mLBSProxy->requestUlp(adapter, capabilities);
     }
+
+private:
+    // kept behind the members above, so their offsets in prebuilt
+    // libraries still hold
+    const LOC_API_ADAPTER_EVENT_MASK_T mExMask;
+    const char* mLibName;
+    pthread_mutex_t mReadyLock;
+    pthread_cond_t mReadyCond;
+    bool mBringingUp;
+    bool mReady;
+    // the bring up message holds this context until it has run
+    bool mBringUpMsgDone;
 };
 
 } // namespace loc_core
@@ -36,6 +36,25 @@
 
 namespace loc_core {
 
+struct LocAdapterBase::AttachMsg : public LocMsg {
+    LocAdapterBase* mAdapter;
+    inline AttachMsg(LocAdapterBase* adapter) :
+        LocMsg(), mAdapter(adapter)
+    {
+        locallog();
+    }
+    inline virtual void proc() const {
+        mAdapter->mLocApi = mAdapter->mContext->getLocApi();
+        mAdapter->mLocApi->addAdapter(mAdapter);
+    }
+    inline void locallog() const {
+        LOC_LOGV("LocAdapterBase attach: %p", mAdapter);
+    }
+    inline virtual void log() const {
+        locallog();
+    }
+};
+
 // This is the top level class, so the constructor will
 // always gets called. Here we prepare for the default.
 // But if getLocApi(targetEnumType target) is overriden,
@@ -43,9 +62,11 @@ namespace loc_core {
 LocAdapterBase::LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
                                ContextBase* context) :
     mEvtMask(mask), mContext(context),
-    mLocApi(context->getLocApi()), mMsgTask(context->getMsgTask())
+    mLocApi(NULL), mMsgTask(context->getMsgTask())
 {
-    mLocApi->addAdapter(this);
+    // the context brings its LocApi up on the MsgTask, the adapter is
+    // attached right behind it, ahead of any request it sends
+    sendMsg(new AttachMsg(this));
 }
 
 void LocAdapterBase::
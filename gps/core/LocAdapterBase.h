@@ -36,6 +36,7 @@
 namespace loc_core {
 
 class LocAdapterBase {
+    struct AttachMsg;
 protected:
     const LOC_API_ADAPTER_EVENT_MASK_T mEvtMask;
     ContextBase* mContext;
@@ -45,7 +46,11 @@ protected:
     inline LocAdapterBase(const MsgTask* msgTask) :
         mEvtMask(0), mContext(NULL), mLocApi(NULL), mMsgTask(msgTask) {}
 public:
-    inline virtual ~LocAdapterBase() { mLocApi->removeAdapter(this); }
+    inline virtual ~LocAdapterBase() {
+        if (NULL != mLocApi) {
+            mLocApi->removeAdapter(this);
+        }
+    }
     LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
                    ContextBase* context);
     inline LOC_API_ADAPTER_EVENT_MASK_T
@@ -52,6 +52,10 @@ LocDualContext::mBgExclMask =
      LOC_API_ADAPTER_BIT_STATUS_REPORT |
      LOC_API_ADAPTER_BIT_GEOFENCE_GEN_ALERT);
 
+// foreground messages taken for each background one while both wait
+const int LocDualContext::mFgWeight = 4;
+const int LocDualContext::mBgWeight = 1;
+
 const MsgTask* LocDualContext::mMsgTask = NULL;
 ContextBase* LocDualContext::mFgContext = NULL;
 ContextBase* LocDualContext::mBgContext = NULL;
@@ -82,7 +86,8 @@ ContextBase* LocDualContext::getLocFgContext(MsgTask::tCreate tCreator,
                                              const char* name)
 {
     if (NULL == mFgContext) {
-        const MsgTask* msgTask = getMsgTask(tCreator, name);
+        const MsgTask* msgTask = new MsgTask(getMsgTask(tCreator, name),
+                                             mFgWeight);
         mFgContext = new LocDualContext(msgTask,
                                         mFgExclMask);
     }
@@ -93,7 +98,8 @@ ContextBase* LocDualContext::getLocFgContext(MsgTask::tAssociate tAssociate,
                                         const char* name)
 {
     if (NULL == mFgContext) {
-        const MsgTask* msgTask = getMsgTask(tAssociate, name);
+        const MsgTask* msgTask = new MsgTask(getMsgTask(tAssociate, name),
+                                             mFgWeight);
         mFgContext = new LocDualContext(msgTask,
                                         mFgExclMask);
     }
@@ -105,7 +111,8 @@ ContextBase* LocDualContext::getLocBgContext(MsgTask::tCreate tCreator,
                                              const char* name)
 {
     if (NULL == mBgContext) {
-        const MsgTask* msgTask = getMsgTask(tCreator, name);
+        const MsgTask* msgTask = new MsgTask(getMsgTask(tCreator, name),
+                                             mBgWeight);
         mBgContext = new LocDualContext(msgTask,
                                         mBgExclMask);
     }
@@ -116,7 +123,8 @@ ContextBase* LocDualContext::getLocBgContext(MsgTask::tAssociate tAssociate,
                                              const char* name)
 {
     if (NULL == mBgContext) {
-        const MsgTask* msgTask = getMsgTask(tAssociate, name);
+        const MsgTask* msgTask = new MsgTask(getMsgTask(tAssociate, name),
+                                             mBgWeight);
         mBgContext = new LocDualContext(msgTask,
                                         mBgExclMask);
     }
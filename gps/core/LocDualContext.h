@@ -36,7 +36,20 @@
 
 namespace loc_core {
 
+// Both contexts run on one MsgTask thread, each with its own queue on it.
+// The thread takes up to mFgWeight foreground messages for each background
+// one, so a busy background client (geofence, batching, IZAT proxy
+// traffic) does not hold back fix delivery.
+//
+// Thread affinity for adapters: an adapter runs on the MsgTask thread, and
+// so does every adapter of either context, so they may share state without
+// locks. Messages are processed in order within a context only; an adapter
+// must not expect a message sent to the other context to be processed
+// before, or after, one sent to its own. That holds for the bring up of
+// the other context too, unless it was created on the MsgTask thread.
 class LocDualContext : public ContextBase {
+    static const int mFgWeight;
+    static const int mBgWeight;
     static const MsgTask* mMsgTask;
     static ContextBase* mFgContext;
     static ContextBase* mBgContext;
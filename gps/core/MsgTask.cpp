@@ -30,6 +30,7 @@
 #define LOG_TAG "LocSvc_MsgTask"
 
 #include <cutils/sched_policy.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <MsgTask.h>
 #include <msg_q.h>
@@ -41,6 +42,14 @@ namespace loc_core {
 
 #define MAX_TASK_COMM_LEN 15
 
+// messages processed by all the MsgTasks, read by loc_api_bench
+static uint32_t sMsgsProcessed = 0;
+
+extern "C" uint32_t loc_msg_task_processed()
+{
+    return __sync_fetch_and_add(&sMsgsProcessed, 0);
+}
+
 static void LocMsgDestroy(void* msg) {
     delete (LocMsg*)msg;
 }
@@ -60,6 +69,10 @@ MsgTask::MsgTask(tAssociate tAssociator, const char* threadName) :
     createPThread(threadName);
 }
 
+MsgTask::MsgTask(const MsgTask* shared, int weight) :
+    mQ(msg_q_init_lane((void*)shared->mQ, weight)), mAssociator(NULL){
+}
+
 inline
 MsgTask::MsgTask(const void* q, tAssociate associator) :
     mQ(q), mAssociator(associator){
@@ -91,6 +104,10 @@ void MsgTask::sendMsg(const LocMsg* msg) const {
     msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
 }
 
+bool MsgTask::isTaskThread() const {
+    return msg_q_is_receiver(mQ);
+}
+
 void* MsgTask::loopMain(void* arg) {
     MsgTask* copy = (MsgTask*)arg;
 
@@ -123,6 +140,7 @@ void* MsgTask::loopMain(void* arg) {
         msg->proc();
 
         delete msg;
+        __sync_fetch_and_add(&sMsgsProcessed, 1);
     }
 
     delete copy;
@@ -50,8 +50,13 @@ public:
     typedef int (*tAssociate)();
     MsgTask(tCreate tCreator, const char* threadName);
     MsgTask(tAssociate tAssociator, const char* threadName);
+    // a queue of its own, processed on the thread of shared, which takes
+    // up to weight messages in a row from it while the others wait
+    MsgTask(const MsgTask* shared, int weight);
     ~MsgTask();
     void sendMsg(const LocMsg* msg) const;
+    // true when called from a message processed by this task
+    bool isTaskThread() const;
 
 private:
     const void* mQ;
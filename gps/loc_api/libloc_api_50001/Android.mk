@@ -25,6 +25,11 @@ LOCAL_SRC_FILES += \
     loc_eng_ni.cpp \
     loc_eng_log.cpp \
     loc_eng_nmea.cpp \
+    loc_eng_pos_cache.cpp \
+    loc_eng_batch.cpp \
+    loc_eng_geofence.cpp \
+    loc_eng_sv_filter.cpp \
+    loc_eng_inject_filter.cpp \
     LocEngAdapter.cpp
 
 LOCAL_SRC_FILES += \
@@ -52,7 +57,12 @@ LOCAL_COPY_HEADERS:= \
    loc_eng_ni.h \
    loc_eng_agps.h \
    loc_eng_msg.h \
-   loc_eng_log.h
+   loc_eng_log.h \
+   loc_eng_pos_cache.h \
+   loc_eng_batch.h \
+   loc_eng_geofence.h \
+   loc_eng_sv_filter.h \
+   loc_eng_inject_filter.h
 
 LOCAL_PRELINK_MODULE := false
 
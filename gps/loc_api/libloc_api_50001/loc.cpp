@@ -141,6 +141,27 @@ static const AGpsRilInterface sLocEngAGpsRilInterface =
    loc_agps_ril_update_network_availability
 };
 
+static void loc_geofence_init(GpsGeofenceCallbacks* callbacks);
+static void loc_geofence_add_area(int32_t geofence_id, double latitude,
+                                  double longitude, double radius_meters,
+                                  int last_transition, int monitor_transitions,
+                                  int notification_responsiveness_ms,
+                                  int unknown_timer_ms);
+static void loc_geofence_pause(int32_t geofence_id);
+static void loc_geofence_resume(int32_t geofence_id, int monitor_transitions);
+static void loc_geofence_remove_area(int32_t geofence_id);
+
+// The in-tree engine, used without a vendor libgeofence.so
+static const GpsGeofencingInterface sLocEngGeofenceInterface =
+{
+   sizeof(GpsGeofencingInterface),
+   loc_geofence_init,
+   loc_geofence_add_area,
+   loc_geofence_pause,
+   loc_geofence_resume,
+   loc_geofence_remove_area
+};
+
 static loc_eng_data_s_type loc_afw_data;
 static int gss_fd = -1;
 
@@ -277,9 +298,7 @@ static int loc_init(GpsCallbacks* callbacks)
     gps_sv_cb = callbacks->sv_status_cb;
 
     retVal = loc_eng_init(loc_afw_data, &clientCallbacks, event, NULL);
-    loc_afw_data.adapter->requestUlp(gps_conf.CAPABILITIES);
-    loc_afw_data.adapter->mAgpsEnabled = !loc_afw_data.adapter->hasAgpsExt();
-    loc_afw_data.adapter->mCPIEnabled = !loc_afw_data.adapter->hasCPIExt();
+    loc_eng_request_ulp(loc_afw_data, gps_conf.CAPABILITIES);
 
     EXIT_LOG(%d, retVal);
     return retVal;
@@ -553,6 +572,10 @@ const GpsGeofencingInterface* get_geofence_interface(void)
     geofence_interface = get_gps_geofence_interface();
 
 exit:
+    if (NULL == geofence_interface) {
+        LOC_LOGD("%s, using the in-tree geofence engine\n", __func__);
+        geofence_interface = &sLocEngGeofenceInterface;
+    }
     EXIT_LOG(%d, geofence_interface == NULL);
     return geofence_interface;
 }
@@ -880,6 +903,79 @@ void loc_ni_respond(int notif_id, GpsUserResponseType user_response)
     EXIT_LOG(%s, VOID_RET);
 }
 
+/*===========================================================================
+FUNCTION    loc_geofence_init
+
+DESCRIPTION
+   Initializes the in-tree geofence engine
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_geofence_init(GpsGeofenceCallbacks* callbacks)
+{
+    ENTRY_LOG();
+    loc_eng_geofence_init(loc_afw_data, callbacks);
+    EXIT_LOG(%s, VOID_RET);
+}
+
+/*===========================================================================
+FUNCTION    loc_geofence_add_area
+
+DESCRIPTION
+   Adds a circular fence. Fixes are checked as they come, so the
+   responsiveness and the unknown timer are not used.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_geofence_add_area(int32_t geofence_id, double latitude,
+                                  double longitude, double radius_meters,
+                                  int last_transition, int monitor_transitions,
+                                  int notification_responsiveness_ms,
+                                  int unknown_timer_ms)
+{
+    ENTRY_LOG();
+    loc_eng_geofence_add(loc_afw_data, geofence_id, latitude, longitude,
+                         radius_meters, last_transition, monitor_transitions);
+    EXIT_LOG(%s, VOID_RET);
+}
+
+static void loc_geofence_pause(int32_t geofence_id)
+{
+    ENTRY_LOG();
+    loc_eng_geofence_pause(loc_afw_data, geofence_id);
+    EXIT_LOG(%s, VOID_RET);
+}
+
+static void loc_geofence_resume(int32_t geofence_id, int monitor_transitions)
+{
+    ENTRY_LOG();
+    loc_eng_geofence_resume(loc_afw_data, geofence_id, monitor_transitions);
+    EXIT_LOG(%s, VOID_RET);
+}
+
+static void loc_geofence_remove_area(int32_t geofence_id)
+{
+    ENTRY_LOG();
+    loc_eng_geofence_remove(loc_afw_data, geofence_id);
+    EXIT_LOG(%s, VOID_RET);
+}
+
 // Below stub functions are members of sLocEngAGpsRilInterface
 static void loc_agps_ril_init( AGpsRilCallbacks* callbacks ) {}
 static void loc_agps_ril_set_ref_location(const AGpsRefLocation *agps_reflocation, size_t sz_struct) {}
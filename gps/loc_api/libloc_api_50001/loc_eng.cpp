@@ -72,6 +72,7 @@
 #include "platform_lib_includes.h"
 #include "loc_core_log.h"
 #include "loc_eng_log.h"
+#include "loc_timer.h"
 
 #define SUCCESS TRUE
 #define FAILURE FALSE
@@ -118,6 +119,21 @@ static loc_param_s_type loc_parameter_table[] =
   {"QUIPC_ENABLED",                  &gps_conf.QUIPC_ENABLED,                  NULL, 'n'},
   {"LPP_PROFILE",                    &gps_conf.LPP_PROFILE,                    NULL, 'n'},
   {"A_GLONASS_POS_PROTOCOL_SELECT",  &gps_conf.A_GLONASS_POS_PROTOCOL_SELECT,  NULL, 'n'},
+  {"ZPP_CACHE_MAX_AGE",              &gps_conf.ZPP_CACHE_MAX_AGE,              NULL, 'n'},
+  {"ZPP_CACHE_ACCURACY",             &gps_conf.ZPP_CACHE_ACCURACY,             NULL, 'n'},
+  {"BATCH_SIZE",                     &gps_conf.BATCH_SIZE,                     NULL, 'n'},
+  {"BATCH_FLUSH_INTERVAL",           &gps_conf.BATCH_FLUSH_INTERVAL,           NULL, 'n'},
+  {"BATCH_OVERFLOW",                 &gps_conf.BATCH_OVERFLOW,                 NULL, 'n'},
+  {"GEOFENCE_DWELL_TIME",            &gps_conf.GEOFENCE_DWELL_TIME,            NULL, 'n'},
+  {"GEOFENCE_HYSTERESIS",            &gps_conf.GEOFENCE_HYSTERESIS,            NULL, 'n'},
+  {"SV_REPORT_SUPPRESS",             &gps_conf.SV_REPORT_SUPPRESS,             NULL, 'n'},
+  {"SV_REPORT_SNR_STEP",             &gps_conf.SV_REPORT_SNR_STEP,             NULL, 'n'},
+  {"SV_REPORT_ANGLE_STEP",           &gps_conf.SV_REPORT_ANGLE_STEP,           NULL, 'n'},
+  {"SV_REPORT_MIN_INTERVAL",         &gps_conf.SV_REPORT_MIN_INTERVAL,         NULL, 'n'},
+  {"INJECT_FILTER",                  &gps_conf.INJECT_FILTER,                  NULL, 'n'},
+  {"INJECT_MIN_DISTANCE",            &gps_conf.INJECT_MIN_DISTANCE,            NULL, 'n'},
+  {"INJECT_MIN_INTERVAL",            &gps_conf.INJECT_MIN_INTERVAL,            NULL, 'n'},
+  {"INJECT_MAX_AGE",                 &gps_conf.INJECT_MAX_AGE,                 NULL, 'n'},
 };
 
 static void loc_default_parameters(void)
@@ -160,6 +176,42 @@ static void loc_default_parameters(void)
 
    /*By default no positioning protocol is selected on A-GLONASS system*/
    gps_conf.A_GLONASS_POS_PROTOCOL_SELECT = 0;
+
+   /* ZPP is answered with final fixes up to 30 secs old, accurate to
+      100 meters, before going to the modem. 0 secs turns the cache off,
+      0 meters accepts any accuracy */
+   gps_conf.ZPP_CACHE_MAX_AGE = 30;
+   gps_conf.ZPP_CACHE_ACCURACY = 100;
+
+   /* Batching is off unless BATCH_SIZE fixes are set aside for it. A batch
+      is delivered once it is BATCH_FLUSH_INTERVAL secs old, 0 for never,
+      and on overflow as per BATCH_OVERFLOW */
+   gps_conf.BATCH_SIZE = 0;
+   gps_conf.BATCH_FLUSH_INTERVAL = 60;
+   gps_conf.BATCH_OVERFLOW = LOC_ENG_BATCH_OVERFLOW_FLUSH;
+
+   /* The in-tree geofence engine reports a transition once the fixes agree
+      on it for GEOFENCE_DWELL_TIME msec, and lets the position wander
+      across a fence boundary by at least GEOFENCE_HYSTERESIS meters */
+   gps_conf.GEOFENCE_DWELL_TIME = 0;
+   gps_conf.GEOFENCE_HYSTERESIS = 10;
+
+   /* Sv reports which look the same as the last one delivered, to 1 dB and
+      1 degree, are not delivered to the framework. No more than one is
+      delivered every SV_REPORT_MIN_INTERVAL msec, 0 for no limit. The NMEA
+      sentences are still generated for every report */
+   gps_conf.SV_REPORT_SUPPRESS = 1;
+   gps_conf.SV_REPORT_SNR_STEP = 1;
+   gps_conf.SV_REPORT_ANGLE_STEP = 1;
+   gps_conf.SV_REPORT_MIN_INTERVAL = 1000;
+
+   /* A coarse position is only injected if it moved by 100 meters, or got
+      that much more accurate, or the last one is 10 minutes old. In a
+      session no more than one is injected every 30 seconds */
+   gps_conf.INJECT_FILTER = 1;
+   gps_conf.INJECT_MIN_DISTANCE = 100;
+   gps_conf.INJECT_MIN_INTERVAL = 30000;
+   gps_conf.INJECT_MAX_AGE = 600000;
 }
 
 // 2nd half of init(), singled out for
@@ -362,7 +414,17 @@ struct LocEngInjectLocation : public LocMsg {
         locallog();
     }
     inline virtual void proc() const {
-        mAdapter->injectPosition(mLatitude, mLongitude, mAccuracy);
+        // mCPIEnabled is only known once the context is up
+        if (!mAdapter->mCPIEnabled) {
+            loc_eng_data_s_type* locEng =
+                (loc_eng_data_s_type*)mAdapter->getOwner();
+            if (loc_eng_inject_filter_check(locEng->inject_filter,
+                                            mLatitude, mLongitude,
+                                            mAccuracy,
+                                            mAdapter->isInSession())) {
+                mAdapter->injectPosition(mLatitude, mLongitude, mAccuracy);
+            }
+        }
     }
     inline void locallog() const {
         LOC_LOGV("latitude: %f\n  longitude: %f\n  accuracy: %f",
@@ -683,6 +745,94 @@ struct LocEngExtPowerConfig : public LocMsg {
     }
 };
 
+struct LocEngFlushBatch : public LocMsg {
+    loc_eng_data_s_type* mLocEng;
+    // set by the flush timer, for the batch it was armed for
+    const bool mTimeout;
+    const uint32_t mGeneration;
+    inline LocEngFlushBatch(loc_eng_data_s_type* locEng) :
+        LocMsg(), mLocEng(locEng), mTimeout(false), mGeneration(0)
+    {
+        locallog();
+    }
+    inline LocEngFlushBatch(loc_eng_data_s_type* locEng,
+                            uint32_t generation) :
+        LocMsg(), mLocEng(locEng), mTimeout(true), mGeneration(generation)
+    {
+        locallog();
+    }
+    inline virtual void proc() const {
+        // a timer for a batch delivered since is ignored
+        if (!mTimeout || mGeneration == mLocEng->batch.generation) {
+            loc_eng_batch_deliver(mLocEng->batch, mLocEng->location_cb);
+        }
+    }
+    inline void locallog() const {
+        LOC_LOGV("LocEngFlushBatch, timeout %d, generation %u",
+                 mTimeout, mGeneration);
+    }
+    virtual void log() const {
+        locallog();
+    }
+};
+
+struct loc_eng_batch_timer_s_type {
+    loc_eng_data_s_type* locEng;
+    uint32_t generation;
+};
+
+static void loc_eng_batch_timer_cb(void* user_data, int result)
+{
+    loc_eng_batch_timer_s_type* timer = (loc_eng_batch_timer_s_type*)user_data;
+
+    // runs on the timer thread, the batch is for the MsgTask to touch
+    timer->locEng->adapter->sendMsg(
+        new LocEngFlushBatch(timer->locEng, timer->generation));
+    delete timer;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_batch_fix
+
+DESCRIPTION
+   Holds a fix back in the batch instead of reporting it. The first fix of
+   a batch arms a timer which delivers it BATCH_FLUSH_INTERVAL secs later.
+   The timer is never stopped, a delivery in the meantime makes it stale.
+
+DEPENDENCIES
+   Batching enabled
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_eng_batch_fix(loc_eng_data_s_type* locEng,
+                              const UlpLocation &location,
+                              void* locationExt)
+{
+    loc_eng_batch_s_type &batch = locEng->batch;
+
+    if (loc_eng_batch_add(batch, location, locationExt)) {
+        loc_eng_batch_deliver(batch, locEng->location_cb);
+    }
+
+    if (batch.count > 0 && !batch.timerArmed &&
+        gps_conf.BATCH_FLUSH_INTERVAL > 0) {
+        loc_eng_batch_timer_s_type* timer = new loc_eng_batch_timer_s_type;
+        timer->locEng = locEng;
+        timer->generation = batch.generation;
+        if (NULL == loc_timer_start(gps_conf.BATCH_FLUSH_INTERVAL * 1000,
+                                    loc_eng_batch_timer_cb, timer)) {
+            delete timer;
+        } else {
+            batch.timerArmed = true;
+        }
+    }
+}
+
 //        case LOC_ENG_MSG_REPORT_POSITION:
 LocEngReportPosition::LocEngReportPosition(LocAdapterBase* adapter,
                                            UlpLocation &loc,
@@ -703,6 +853,13 @@ void LocEngReportPosition::proc() const {
     LocEngAdapter* adapter = (LocEngAdapter*)mAdapter;
     loc_eng_data_s_type* locEng = (loc_eng_data_s_type*)adapter->getOwner();
 
+    loc_eng_pos_cache_add(locEng->pos_cache, mLocation, mLocationExtended,
+                          mStatus, mTechMask);
+
+    if (LOC_SESS_SUCCESS == mStatus) {
+        loc_eng_geofence_report_position(*locEng, mLocation);
+    }
+
     if (locEng->mute_session_state != LOC_MUTE_SESS_IN_SESSION) {
         bool reported = false;
         if (locEng->location_cb != NULL) {
@@ -732,8 +889,16 @@ void LocEngReportPosition::proc() const {
                         (gps_conf.ACCURACY_THRES != 0) &&
                         (mLocation.gpsLocation.accuracy >
                          gps_conf.ACCURACY_THRES)))) {
-                locEng->location_cb((UlpLocation*)&(mLocation),
-                                    (void*)mLocationExt);
+                // a single shot client waits for its fix
+                if (loc_eng_batch_enabled(locEng->batch) &&
+                    GPS_POSITION_RECURRENCE_PERIODIC ==
+                    locEng->adapter->getPositionMode().recurrence) {
+                    loc_eng_batch_fix(locEng, mLocation,
+                                      (void*)mLocationExt);
+                } else {
+                    locEng->location_cb((UlpLocation*)&(mLocation),
+                                        (void*)mLocationExt);
+                }
                 reported = true;
             }
         }
@@ -750,6 +915,7 @@ void LocEngReportPosition::proc() const {
             }
             // turn off the session flag.
             locEng->adapter->setInSession(false);
+            loc_eng_geofence_report_session(*locEng);
         }
 
         if (locEng->generateNmea &&
@@ -802,7 +968,7 @@ LocEngReportSv::LocEngReportSv(LocAdapterBase* adapter,
             ((LocEngAdapter*)
              (mAdapter))->getOwner())->sv_ext_parser(svExt))
 {
-    locallog();
+    // the MsgTask logs it on delivery
 }
 void LocEngReportSv::proc() const {
     LocEngAdapter* adapter = (LocEngAdapter*)mAdapter;
@@ -810,7 +976,11 @@ void LocEngReportSv::proc() const {
 
     if (locEng->mute_session_state != LOC_MUTE_SESS_IN_SESSION)
     {
-        if (locEng->sv_status_cb != NULL) {
+        // NMEA clients count on the sentences at the usual rate, so only
+        // the callback is held back
+        if (locEng->sv_status_cb != NULL &&
+            loc_eng_sv_filter_check(locEng->sv_filter, mSvStatus)) {
+            logSvs();
             locEng->sv_status_cb((GpsSvStatus*)&(mSvStatus),
                                  (void*)mSvExt);
         }
@@ -823,10 +993,13 @@ void LocEngReportSv::proc() const {
 }
 void LocEngReportSv::locallog() const {
     LOC_LOGV("num sv: %d\n  ephemeris mask: %dxn  almanac mask: %x\n  "
-             "used in fix mask: %x\n      sv: prn         snr       "
-             "elevation      azimuth",
+             "used in fix mask: %x",
              mSvStatus.num_svs, mSvStatus.ephemeris_mask,
              mSvStatus.almanac_mask, mSvStatus.used_in_fix_mask);
+}
+// only for the reports delivered, most are held back by the filter
+void LocEngReportSv::logSvs() const {
+    LOC_LOGV("      sv: prn         snr       elevation      azimuth");
     for (int i = 0; i < mSvStatus.num_svs && i < GPS_MAX_SVS; i++) {
         LOC_LOGV("   %d:   %d    %f    %f    %f\n  ",
                  i,
@@ -1243,6 +1416,11 @@ struct LocEngDelAidData : public LocMsg {
         locallog();
     }
     inline virtual void proc() const {
+        if (mType & GPS_DELETE_POSITION) {
+            loc_eng_pos_cache_clear(mLocEng->pos_cache);
+            // the modem no longer has the last coarse position either
+            loc_eng_inject_filter_reset(mLocEng->inject_filter);
+        }
         mLocEng->aiding_data_for_deletion = mType;
         update_aiding_data_for_deletion(*mLocEng);
     }
@@ -1317,6 +1495,30 @@ struct LocEngInit : public LocMsg {
     }
 };
 
+struct LocEngRequestUlp : public LocMsg {
+    LocEngAdapter* mAdapter;
+    const unsigned long mCapabilities;
+    inline LocEngRequestUlp(LocEngAdapter* adapter,
+                            unsigned long capabilities) :
+        LocMsg(), mAdapter(adapter), mCapabilities(capabilities)
+    {
+        locallog();
+    }
+    inline virtual void proc() const {
+        mAdapter->requestUlp(mCapabilities);
+        mAdapter->mAgpsEnabled = !mAdapter->hasAgpsExt();
+        mAdapter->mCPIEnabled = !mAdapter->hasCPIExt();
+    }
+    inline void locallog() const
+    {
+        LOC_LOGV("LocEngRequestUlp - capabilities: %lx", mCapabilities);
+    }
+    inline virtual void log() const
+    {
+        locallog();
+    }
+};
+
 //        case LOC_ENG_MSG_REQUEST_XTRA_SERVER:
 // loc_eng_xtra.cpp
 
@@ -1429,17 +1631,25 @@ inline void LocEngUp::log() const {
 
 struct LocEngDataClientInit : public LocMsg {
     loc_eng_data_s_type* mLocEng;
-    inline LocEngDataClientInit(loc_eng_data_s_type* locEng) :
-        LocMsg(), mLocEng(locEng) {
+    const gps_create_thread mThreadCreator;
+    inline LocEngDataClientInit(loc_eng_data_s_type* locEng,
+                                gps_create_thread threadCreator) :
+        LocMsg(), mLocEng(locEng), mThreadCreator(threadCreator) {
         locallog();
     }
     virtual void proc() const {
         loc_eng_data_s_type *locEng = (loc_eng_data_s_type *)mLocEng;
+        // mAgpsEnabled is only known once the context is up
+        if (!locEng->adapter->mAgpsEnabled) {
+            return;
+        }
         if(!locEng->adapter->initDataServiceClient()) {
             locEng->ds_nif = new DSStateMachine(servicerTypeExt,
                                                (void *)dataCallCb,
                                                locEng->adapter);
         }
+        loc_eng_dmn_conn_loc_api_server_launch(mThreadCreator,
+                                               NULL, NULL, locEng);
     }
     void locallog() const {
         LOC_LOGV("LocEngDataClientInit\n");
@@ -1516,6 +1726,8 @@ int loc_eng_init(loc_eng_data_s_type &loc_eng_data, LocCallbacks* callbacks,
     loc_eng_data.sv_ext_parser = callbacks->sv_ext_parser ?
         callbacks->sv_ext_parser : noProc;
     loc_eng_data.intermediateFix = gps_conf.INTERMEDIATE_POS;
+    loc_eng_batch_init(loc_eng_data.batch, (int)gps_conf.BATCH_SIZE,
+                       (loc_eng_batch_overflow_e_type)gps_conf.BATCH_OVERFLOW);
 
     // initial states taken care of by the memset above
     // loc_eng_data.engine_status -- GPS_STATUS_NONE;
@@ -1544,6 +1756,36 @@ int loc_eng_init(loc_eng_data_s_type &loc_eng_data, LocCallbacks* callbacks,
     return ret_val;
 }
 
+/*===========================================================================
+FUNCTION    loc_eng_request_ulp
+
+DESCRIPTION
+   Requests the ULP and the AGPS / CPI extensions from the LBS proxy. The
+   proxy is loaded on the MsgTask, so this is queued behind it rather than
+   waited for.
+
+DEPENDENCIES
+   loc_eng_init
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_eng_request_ulp(loc_eng_data_s_type &loc_eng_data,
+                         unsigned long capabilities)
+{
+    ENTRY_LOG_CALLFLOW();
+    INIT_CHECK(loc_eng_data.adapter, return);
+
+    loc_eng_data.adapter->sendMsg(new LocEngRequestUlp(loc_eng_data.adapter,
+                                                       capabilities));
+
+    EXIT_LOG(%s, VOID_RET);
+}
+
 static int loc_eng_reinit(loc_eng_data_s_type &loc_eng_data)
 {
     ENTRY_LOG();
@@ -1638,9 +1880,14 @@ void loc_eng_cleanup(loc_eng_data_s_type &loc_eng_data)
         loc_eng_stop(loc_eng_data);
     }
 
+    // the engine stays up, and with it the batch for the next client,
+    // which loc_eng_init does not set up again
+    loc_eng_flush_batch(loc_eng_data);
+
 #if 0 // can't afford to actually clean up, for many reason.
 
     LOC_LOGD("loc_eng_init: client opened. close it now.");
+    loc_eng_batch_deinit(loc_eng_data.batch);
     delete loc_eng_data.adapter;
     loc_eng_data.adapter = NULL;
 
@@ -1689,13 +1936,27 @@ static int loc_eng_start_handler(loc_eng_data_s_type &loc_eng_data)
    int ret_val = LOC_API_ADAPTER_ERR_SUCCESS;
 
    if (!loc_eng_data.adapter->isInSession()) {
+       double latitude, longitude;
+       float accuracy;
+       // the coarse position held back during the last session
+       if (!loc_eng_data.adapter->mCPIEnabled &&
+           loc_eng_inject_filter_take_pending(loc_eng_data.inject_filter,
+                                              latitude, longitude,
+                                              accuracy)) {
+           loc_eng_data.adapter->injectPosition(latitude, longitude,
+                                                accuracy);
+       }
+
        ret_val = loc_eng_data.adapter->startFix();
 
        if (ret_val == LOC_API_ADAPTER_ERR_SUCCESS ||
            ret_val == LOC_API_ADAPTER_ERR_ENGINE_DOWN)
        {
+           // a new session starts with a fresh sv report
+           loc_eng_sv_filter_reset(loc_eng_data.sv_filter);
            loc_eng_data.adapter->setInSession(TRUE);
            loc_inform_gps_status(loc_eng_data, GPS_STATUS_SESSION_BEGIN);
+           loc_eng_geofence_report_session(loc_eng_data);
        }
    }
 
@@ -1729,6 +1990,9 @@ int loc_eng_stop(loc_eng_data_s_type &loc_eng_data)
         loc_eng_data.adapter->sendMsg(new LocEngStopFix(loc_eng_data.adapter));
     }
 
+    // also when the ULP stops the session, which bypasses the stop handler
+    loc_eng_flush_batch(loc_eng_data);
+
     EXIT_LOG(%d, 0);
     return 0;
 }
@@ -1741,18 +2005,49 @@ static int loc_eng_stop_handler(loc_eng_data_s_type &loc_eng_data)
    if (loc_eng_data.adapter->isInSession()) {
 
        ret_val = loc_eng_data.adapter->stopFix();
+
+       // the client gets the whole track before the session ends
+       loc_eng_batch_deliver(loc_eng_data.batch, loc_eng_data.location_cb);
+
        if (ret_val == LOC_API_ADAPTER_ERR_SUCCESS)
        {
            loc_inform_gps_status(loc_eng_data, GPS_STATUS_SESSION_END);
        }
 
        loc_eng_data.adapter->setInSession(FALSE);
+       loc_eng_geofence_report_session(loc_eng_data);
    }
 
     EXIT_LOG(%d, ret_val);
     return ret_val;
 }
 
+/*===========================================================================
+FUNCTION    loc_eng_flush_batch
+
+DESCRIPTION
+   Delivers the batched fixes now, rather than on timeout or overflow
+
+DEPENDENCIES
+   None
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_eng_flush_batch(loc_eng_data_s_type &loc_eng_data)
+{
+    ENTRY_LOG_CALLFLOW();
+    INIT_CHECK(loc_eng_data.adapter, return);
+
+    loc_eng_data.adapter->sendMsg(new LocEngFlushBatch(&loc_eng_data));
+
+    EXIT_LOG(%s, VOID_RET);
+}
+
 /*===========================================================================
 FUNCTION    loc_eng_mute_one_session
 
@@ -1871,11 +2166,8 @@ int loc_eng_inject_location(loc_eng_data_s_type &loc_eng_data, double latitude,
     ENTRY_LOG_CALLFLOW();
     INIT_CHECK(loc_eng_data.adapter, return -1);
     LocEngAdapter* adapter = loc_eng_data.adapter;
-    if(!adapter->mCPIEnabled)
-    {
-        adapter->sendMsg(new LocEngInjectLocation(adapter, latitude, longitude,
-                                                  accuracy));
-    }
+    adapter->sendMsg(new LocEngInjectLocation(adapter, latitude, longitude,
+                                              accuracy));
 
     EXIT_LOG(%d, 0);
     return 0;
@@ -1955,7 +2247,14 @@ static int loc_eng_get_zpp_handler(loc_eng_data_s_type &loc_eng_data)
    locationExtended.size = sizeof(locationExtended);
    memset(&location, 0, sizeof location);
 
-   ret_val = loc_eng_data.adapter->getZpp(location.gpsLocation, tech_mask);
+   if (0 == gps_conf.ZPP_CACHE_MAX_AGE ||
+       !loc_eng_pos_cache_get(loc_eng_data.pos_cache,
+                              (int64_t)gps_conf.ZPP_CACHE_MAX_AGE * 1000,
+                              (float)gps_conf.ZPP_CACHE_ACCURACY,
+                              location, locationExtended, tech_mask)) {
+       // nothing recent enough in memory, ask the modem
+       ret_val = loc_eng_data.adapter->getZpp(location.gpsLocation, tech_mask);
+   }
   //Mark the location source as from ZPP
   location.gpsLocation.flags |= LOCATION_HAS_SOURCE_INFO;
   location.position_source = ULP_LOCATION_IS_FROM_ZPP;
@@ -2087,12 +2386,8 @@ void loc_eng_agps_init(loc_eng_data_s_type &loc_eng_data, AGpsExtCallbacks* call
                                                       AGPS_TYPE_SUPL,
                                                       false);
 
-        if (adapter->mAgpsEnabled) {
-            loc_eng_data.adapter->sendMsg(new LocEngDataClientInit(&loc_eng_data));
-
-            loc_eng_dmn_conn_loc_api_server_launch(callbacks->create_thread_cb,
-                                                   NULL, NULL, &loc_eng_data);
-        }
+        adapter->sendMsg(new LocEngDataClientInit(&loc_eng_data,
+                                                  callbacks->create_thread_cb));
         loc_eng_agps_reinit(loc_eng_data);
     }
 
@@ -2536,6 +2831,7 @@ void loc_eng_handle_engine_up(loc_eng_data_s_type &loc_eng_data)
         loc_eng_data.adapter->setPositionMode(NULL);
         loc_eng_data.adapter->setInSession(false);
         loc_eng_start_handler(loc_eng_data);
+        loc_eng_geofence_report_session(loc_eng_data);
     }
     EXIT_LOG(%s, VOID_RET);
 }
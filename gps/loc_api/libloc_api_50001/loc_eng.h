@@ -52,6 +52,11 @@ typedef unsigned char boolean;
 #include <loc_eng_xtra.h>
 #include <loc_eng_ni.h>
 #include <loc_eng_agps.h>
+#include <loc_eng_pos_cache.h>
+#include <loc_eng_batch.h>
+#include <loc_eng_geofence.h>
+#include <loc_eng_sv_filter.h>
+#include <loc_eng_inject_filter.h>
 #include <loc_cfg.h>
 #include <loc_log.h>
 #include <log_util.h>
@@ -133,6 +138,21 @@ typedef struct loc_eng_data_s
 
     loc_ext_parser location_ext_parser;
     loc_ext_parser sv_ext_parser;
+
+    // Recent fixes, for ZPP requests
+    loc_eng_pos_cache_s_type       pos_cache;
+
+    // Fixes held back from location_cb, when batching
+    loc_eng_batch_s_type           batch;
+
+    // In-tree geofencing, without a vendor geofence library
+    loc_eng_geofence_data_s_type   geofence_data;
+
+    // Unchanged or too frequent sv reports are held back
+    loc_eng_sv_filter_s_type       sv_filter;
+
+    // Coarse positions which add nothing are kept from the modem
+    loc_eng_inject_filter_s_type   inject_filter;
 } loc_eng_data_s_type;
 
 /* GPS.conf support */
@@ -146,6 +166,21 @@ typedef struct loc_gps_cfg_s
     unsigned long  LPP_PROFILE;
     uint8_t        NMEA_PROVIDER;
     unsigned long  A_GLONASS_POS_PROTOCOL_SELECT;
+    unsigned long  ZPP_CACHE_MAX_AGE;
+    unsigned long  ZPP_CACHE_ACCURACY;
+    unsigned long  BATCH_SIZE;
+    unsigned long  BATCH_FLUSH_INTERVAL;
+    unsigned long  BATCH_OVERFLOW;
+    unsigned long  GEOFENCE_DWELL_TIME;
+    unsigned long  GEOFENCE_HYSTERESIS;
+    unsigned long  SV_REPORT_SUPPRESS;
+    unsigned long  SV_REPORT_SNR_STEP;
+    unsigned long  SV_REPORT_ANGLE_STEP;
+    unsigned long  SV_REPORT_MIN_INTERVAL;
+    unsigned long  INJECT_FILTER;
+    unsigned long  INJECT_MIN_DISTANCE;
+    unsigned long  INJECT_MIN_INTERVAL;
+    unsigned long  INJECT_MAX_AGE;
 } loc_gps_cfg_s_type;
 
 typedef struct
@@ -180,8 +215,11 @@ int  loc_eng_init(loc_eng_data_s_type &loc_eng_data,
                   LocCallbacks* callbacks,
                   LOC_API_ADAPTER_EVENT_MASK_T event,
                   ContextBase* context);
+void loc_eng_request_ulp(loc_eng_data_s_type &loc_eng_data,
+                         unsigned long capabilities);
 int  loc_eng_start(loc_eng_data_s_type &loc_eng_data);
 int  loc_eng_stop(loc_eng_data_s_type &loc_eng_data);
+void loc_eng_flush_batch(loc_eng_data_s_type &loc_eng_data);
 void loc_eng_cleanup(loc_eng_data_s_type &loc_eng_data);
 int  loc_eng_inject_time(loc_eng_data_s_type &loc_eng_data,
                          GpsUtcTime time, int64_t timeReference,
@@ -216,6 +254,20 @@ bool loc_eng_inject_raw_command(loc_eng_data_s_type &loc_eng_data,
 
 void loc_eng_mute_one_session(loc_eng_data_s_type &loc_eng_data);
 
+void loc_eng_geofence_init(loc_eng_data_s_type &loc_eng_data,
+                           GpsGeofenceCallbacks* callbacks);
+void loc_eng_geofence_add(loc_eng_data_s_type &loc_eng_data, int32_t id,
+                          double latitude, double longitude,
+                          double radius_meters, int last_transition,
+                          int monitor_transitions);
+void loc_eng_geofence_pause(loc_eng_data_s_type &loc_eng_data, int32_t id);
+void loc_eng_geofence_resume(loc_eng_data_s_type &loc_eng_data, int32_t id,
+                             int monitor_transitions);
+void loc_eng_geofence_remove(loc_eng_data_s_type &loc_eng_data, int32_t id);
+void loc_eng_geofence_report_position(loc_eng_data_s_type &loc_eng_data,
+                                      const UlpLocation &location);
+void loc_eng_geofence_report_session(loc_eng_data_s_type &loc_eng_data);
+
 int loc_eng_xtra_init (loc_eng_data_s_type &loc_eng_data,
                        GpsXtraExtCallbacks* callbacks);
 
@@ -0,0 +1,186 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define LOG_NDDEBUG 0
+#define LOG_TAG "LocSvc_eng_batch"
+
+#include <string.h>
+#include <loc_eng_batch.h>
+#include "log_util.h"
+
+/*===========================================================================
+FUNCTION    loc_eng_batch_init
+
+DESCRIPTION
+   Allocates the ring for size fixes up front, so that no allocation
+   happens per fix. A size of 0 leaves batching off.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   true if batching is on
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+bool loc_eng_batch_init(loc_eng_batch_s_type &batch, int size,
+                        loc_eng_batch_overflow_e_type overflow)
+{
+    memset(&batch, 0, sizeof(batch));
+    if (size <= 0) {
+        return false;
+    }
+
+    if (size > LOC_ENG_BATCH_MAX_SIZE) {
+        LOC_LOGW("%s: batch size %d capped to %d", __func__,
+                 size, LOC_ENG_BATCH_MAX_SIZE);
+        size = LOC_ENG_BATCH_MAX_SIZE;
+    }
+
+    batch.entries = new loc_eng_batch_entry_s_type[size];
+    batch.size = size;
+    batch.overflow = overflow;
+    LOC_LOGD("%s: %d fixes, overflow policy %d", __func__, size, overflow);
+    return true;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_batch_deinit
+
+DESCRIPTION
+   Frees the ring, the fixes still in it are lost. The generation carries
+   on, so that a flush timer still armed stays stale.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_eng_batch_deinit(loc_eng_batch_s_type &batch)
+{
+    uint32_t generation = batch.generation;
+
+    delete[] batch.entries;
+    memset(&batch, 0, sizeof(batch));
+    batch.generation = generation + 1;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_batch_add
+
+DESCRIPTION
+   Holds a fix back for the next delivery. A full batch either drops the
+   oldest or the new fix, or, with LOC_ENG_BATCH_OVERFLOW_FLUSH, asks to
+   be delivered as soon as the fix filling it is added.
+
+DEPENDENCIES
+   loc_eng_batch_init
+
+RETURN VALUE
+   true if the batch has to be delivered now
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+bool loc_eng_batch_add(loc_eng_batch_s_type &batch,
+                       const UlpLocation &location, void* locationExt)
+{
+    if (batch.count == batch.size) {
+        if (LOC_ENG_BATCH_OVERFLOW_DROP_NEWEST == batch.overflow) {
+            batch.dropped++;
+            return false;
+        }
+        // with LOC_ENG_BATCH_OVERFLOW_FLUSH only if the caller did not
+        // deliver the full batch
+        batch.tail = (batch.tail + 1) % batch.size;
+        batch.count--;
+        batch.dropped++;
+    }
+
+    loc_eng_batch_entry_s_type* entry =
+        &batch.entries[(batch.tail + batch.count) % batch.size];
+    entry->location = location;
+    // rawData is freed along with the report
+    entry->location.rawData = NULL;
+    entry->location.rawDataSize = 0;
+    // as with a live fix, the client owns what its parser returned
+    entry->locationExt = locationExt;
+    batch.count++;
+
+    return LOC_ENG_BATCH_OVERFLOW_FLUSH == batch.overflow &&
+           batch.count == batch.size;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_batch_deliver
+
+DESCRIPTION
+   Hands all the held fixes, oldest first, to location_cb and empties the
+   batch. Any flush timer armed for it becomes stale.
+
+DEPENDENCIES
+   loc_eng_batch_init
+
+RETURN VALUE
+   number of fixes delivered
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+int loc_eng_batch_deliver(loc_eng_batch_s_type &batch,
+                          loc_location_cb_ext location_cb)
+{
+    int count = batch.count;
+
+    if (count > 0 || batch.dropped > 0) {
+        LOC_LOGD("%s: %d fixes, %u dropped", __func__, count, batch.dropped);
+    }
+
+    for (int i = 0; i < count && NULL != location_cb; i++) {
+        loc_eng_batch_entry_s_type* entry =
+            &batch.entries[(batch.tail + i) % batch.size];
+        location_cb(&entry->location, entry->locationExt);
+    }
+
+    batch.tail = 0;
+    batch.count = 0;
+    batch.dropped = 0;
+    batch.generation++;
+    batch.timerArmed = false;
+    return count;
+}
@@ -0,0 +1,86 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_ENG_BATCH_H
+#define LOC_ENG_BATCH_H
+
+#include <stdint.h>
+#include <loc.h>
+
+// Upper bound of BATCH_SIZE
+#define LOC_ENG_BATCH_MAX_SIZE 1024
+
+// What happens to a new fix when the batch is full, BATCH_OVERFLOW
+enum loc_eng_batch_overflow_e_type {
+    // deliver the batch right away
+    LOC_ENG_BATCH_OVERFLOW_FLUSH = 0,
+    // overwrite the oldest fix
+    LOC_ENG_BATCH_OVERFLOW_DROP_OLDEST,
+    // keep the batch as it is
+    LOC_ENG_BATCH_OVERFLOW_DROP_NEWEST
+};
+
+// A fix held back, with the extension the client parsed for it
+typedef struct
+{
+    UlpLocation                    location;
+    void*                          locationExt;
+} loc_eng_batch_entry_s_type;
+
+// Ring of the fixes held back from location_cb, only touched on the MsgTask
+typedef struct
+{
+    // preallocated, NULL when batching is off
+    loc_eng_batch_entry_s_type*    entries;
+    int                            size;
+    // oldest entry
+    int                            tail;
+    int                            count;
+    loc_eng_batch_overflow_e_type  overflow;
+    // fixes lost to the overflow policy since the last delivery
+    uint32_t                       dropped;
+    // bumped on every delivery, a flush timer armed before is stale
+    uint32_t                       generation;
+    bool                           timerArmed;
+} loc_eng_batch_s_type;
+
+bool loc_eng_batch_init(loc_eng_batch_s_type &batch, int size,
+                        loc_eng_batch_overflow_e_type overflow);
+void loc_eng_batch_deinit(loc_eng_batch_s_type &batch);
+bool loc_eng_batch_add(loc_eng_batch_s_type &batch,
+                       const UlpLocation &location, void* locationExt);
+int loc_eng_batch_deliver(loc_eng_batch_s_type &batch,
+                          loc_location_cb_ext location_cb);
+
+inline bool loc_eng_batch_enabled(const loc_eng_batch_s_type &batch)
+{
+    return NULL != batch.entries;
+}
+
+#endif // LOC_ENG_BATCH_H
@@ -0,0 +1,677 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define LOG_NDDEBUG 0
+#define LOG_TAG "LocSvc_eng_geofence"
+
+#include <math.h>
+#include <string.h>
+#include <loc_eng.h>
+#include <MsgTask.h>
+#include "log_util.h"
+#include "platform_lib_includes.h"
+
+using namespace loc_core;
+
+#define GEOFENCE_METERS_PER_DEGREE 111320.0
+
+/*===========================================================================
+  Spatial index
+===========================================================================*/
+
+static inline int32_t geofence_cell(double degrees)
+{
+    return (int32_t)floor(degrees / LOC_ENG_GEOFENCE_CELL_DEG);
+}
+
+// the same cell on either side of the antimeridian
+static inline int32_t geofence_wrap_lon_cell(int32_t lonCell)
+{
+    const int32_t half = LOC_ENG_GEOFENCE_LON_CELLS / 2;
+    return ((lonCell + half) % LOC_ENG_GEOFENCE_LON_CELLS +
+            LOC_ENG_GEOFENCE_LON_CELLS) % LOC_ENG_GEOFENCE_LON_CELLS - half;
+}
+
+static inline uint32_t geofence_cell_bucket(int32_t latCell, int32_t lonCell)
+{
+    return ((uint32_t)latCell * 73856093u ^ (uint32_t)lonCell * 19349663u) %
+           LOC_ENG_GEOFENCE_GRID_BUCKETS;
+}
+
+static inline uint32_t geofence_id_bucket(int32_t id)
+{
+    return (uint32_t)id % LOC_ENG_GEOFENCE_ID_BUCKETS;
+}
+
+static double geofence_meters_per_lon_degree(double latitude)
+{
+    double c = cos(latitude * M_PI / 180.0);
+    // keep the boxes near the poles finite
+    return GEOFENCE_METERS_PER_DEGREE * (c < 0.01 ? 0.01 : c);
+}
+
+// grid cells covered by the bounding box of the fence, the longitude
+// ones not yet wrapped across the antimeridian
+static void geofence_cells(const loc_eng_geofence_s_type* fence,
+                           int32_t &latMin, int32_t &latMax,
+                           int32_t &lonMin, int32_t &lonMax)
+{
+    double dLat = fence->radius / GEOFENCE_METERS_PER_DEGREE;
+    double dLon = fence->radius /
+                  geofence_meters_per_lon_degree(fence->latitude);
+
+    latMin = geofence_cell(fence->latitude - dLat);
+    latMax = geofence_cell(fence->latitude + dLat);
+    lonMin = geofence_cell(fence->longitude - dLon);
+    lonMax = geofence_cell(fence->longitude + dLon);
+}
+
+static void geofence_index(loc_eng_geofence_data_s_type &data,
+                           loc_eng_geofence_s_type* fence)
+{
+    int32_t latMin, latMax, lonMin, lonMax;
+    geofence_cells(fence, latMin, latMax, lonMin, lonMax);
+
+    if ((int64_t)(latMax - latMin + 1) * (lonMax - lonMin + 1) >
+        LOC_ENG_GEOFENCE_MAX_CELLS) {
+        fence->wide = true;
+        fence->wideNext = data.wide;
+        data.wide = fence;
+        return;
+    }
+
+    for (int32_t lat = latMin; lat <= latMax; lat++) {
+        for (int32_t i = lonMin; i <= lonMax; i++) {
+            int32_t lon = geofence_wrap_lon_cell(i);
+            uint32_t bucket = geofence_cell_bucket(lat, lon);
+            loc_eng_geofence_cell_s_type* cell =
+                new loc_eng_geofence_cell_s_type;
+            cell->latCell = lat;
+            cell->lonCell = lon;
+            cell->fence = fence;
+            cell->next = data.grid[bucket];
+            data.grid[bucket] = cell;
+        }
+    }
+}
+
+static void geofence_unindex(loc_eng_geofence_data_s_type &data,
+                             loc_eng_geofence_s_type* fence)
+{
+    if (fence->wide) {
+        for (loc_eng_geofence_s_type** p = &data.wide; NULL != *p;
+             p = &(*p)->wideNext) {
+            if (*p == fence) {
+                *p = fence->wideNext;
+                break;
+            }
+        }
+        return;
+    }
+
+    int32_t latMin, latMax, lonMin, lonMax;
+    geofence_cells(fence, latMin, latMax, lonMin, lonMax);
+
+    for (int32_t lat = latMin; lat <= latMax; lat++) {
+        for (int32_t i = lonMin; i <= lonMax; i++) {
+            int32_t lon = geofence_wrap_lon_cell(i);
+            loc_eng_geofence_cell_s_type** p =
+                &data.grid[geofence_cell_bucket(lat, lon)];
+            while (NULL != *p) {
+                loc_eng_geofence_cell_s_type* cell = *p;
+                if (cell->fence == fence &&
+                    cell->latCell == lat && cell->lonCell == lon) {
+                    *p = cell->next;
+                    delete cell;
+                    break;
+                }
+                p = &cell->next;
+            }
+        }
+    }
+}
+
+static void geofence_set_active(loc_eng_geofence_data_s_type &data,
+                                loc_eng_geofence_s_type* fence,
+                                bool active)
+{
+    if (active == fence->active) {
+        return;
+    }
+
+    if (active) {
+        fence->activePrev = NULL;
+        fence->activeNext = data.active;
+        if (NULL != data.active) {
+            data.active->activePrev = fence;
+        }
+        data.active = fence;
+    } else {
+        if (NULL != fence->activePrev) {
+            fence->activePrev->activeNext = fence->activeNext;
+        } else {
+            data.active = fence->activeNext;
+        }
+        if (NULL != fence->activeNext) {
+            fence->activeNext->activePrev = fence->activePrev;
+        }
+    }
+    fence->active = active;
+}
+
+static loc_eng_geofence_s_type* geofence_find(
+    const loc_eng_geofence_data_s_type &data, int32_t id)
+{
+    loc_eng_geofence_s_type* fence = data.ids[geofence_id_bucket(id)];
+    while (NULL != fence && fence->id != id) {
+        fence = fence->idNext;
+    }
+    return fence;
+}
+
+/*===========================================================================
+  Evaluation
+===========================================================================*/
+
+static void geofence_transition(loc_eng_geofence_data_s_type &data,
+                                loc_eng_geofence_s_type* fence,
+                                const UlpLocation &location)
+{
+    int32_t transition =
+        LOC_ENG_GEOFENCE_STATE_INSIDE == fence->pendingState ?
+        GPS_GEOFENCE_ENTERED : GPS_GEOFENCE_EXITED;
+
+    fence->state = fence->pendingState;
+    geofence_set_active(data, fence,
+                        LOC_ENG_GEOFENCE_STATE_OUTSIDE != fence->state);
+
+    if ((fence->monitorTransitions & transition) &&
+        NULL != data.callbacks.geofence_transition_callback) {
+        LOC_LOGD("%s: fence %d, transition %d", __func__,
+                 fence->id, transition);
+        data.callbacks.geofence_transition_callback(
+            fence->id, (GpsLocation*)&location.gpsLocation, transition,
+            location.gpsLocation.timestamp);
+    }
+}
+
+/*===========================================================================
+FUNCTION    geofence_evaluate
+
+DESCRIPTION
+   Checks one fix against one fence. The fence counts as entered once the
+   fix is well inside it and as exited once well outside, by at least the
+   fix accuracy or GEOFENCE_HYSTERESIS meters, but no more than half the
+   radius. A fix in the band in between changes nothing. A new state is
+   reported once the fixes agree on it for GEOFENCE_DWELL_TIME msec.
+
+DEPENDENCIES
+   None
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void geofence_evaluate(loc_eng_geofence_data_s_type &data,
+                              loc_eng_geofence_s_type* fence,
+                              const UlpLocation &location, int64_t now)
+{
+    if (fence->evalSeq == data.fixSeq) {
+        // found through more than one path
+        return;
+    }
+    if (fence->evalSeq != data.fixSeq - 1) {
+        // the fixes in between were too far to count towards the dwell
+        fence->pendingState = fence->state;
+    }
+    fence->evalSeq = data.fixSeq;
+
+    if (fence->paused) {
+        return;
+    }
+
+    const GpsLocation &fix = location.gpsLocation;
+    double dy = (fix.latitude - fence->latitude) * GEOFENCE_METERS_PER_DEGREE;
+    double dLon = fix.longitude - fence->longitude;
+    if (dLon > 180.0) {
+        dLon -= 360.0;
+    } else if (dLon < -180.0) {
+        dLon += 360.0;
+    }
+    double dx = dLon * geofence_meters_per_lon_degree(fence->latitude);
+    double distance = sqrt(dx * dx + dy * dy);
+
+    double margin = gps_conf.GEOFENCE_HYSTERESIS;
+    if ((fix.flags & GPS_LOCATION_HAS_ACCURACY) && fix.accuracy > margin) {
+        margin = fix.accuracy;
+    }
+    if (margin > fence->radius / 2) {
+        margin = fence->radius / 2;
+    }
+
+    loc_eng_geofence_state_e_type state;
+    if (distance <= fence->radius - margin) {
+        state = LOC_ENG_GEOFENCE_STATE_INSIDE;
+    } else if (distance >= fence->radius + margin) {
+        state = LOC_ENG_GEOFENCE_STATE_OUTSIDE;
+    } else {
+        return;
+    }
+
+    if (state == fence->state) {
+        fence->pendingState = state;
+        return;
+    }
+
+    if (state != fence->pendingState) {
+        fence->pendingState = state;
+        fence->pendingSince = now;
+    }
+
+    if (now - fence->pendingSince >= (int64_t)gps_conf.GEOFENCE_DWELL_TIME) {
+        geofence_transition(data, fence, location);
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_geofence_report_position
+
+DESCRIPTION
+   Checks a fix against the fences of its grid cell, the wide fences and
+   the fences not known to be outside, and reports their transitions.
+
+DEPENDENCIES
+   Runs on the MsgTask
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_eng_geofence_report_position(loc_eng_data_s_type &loc_eng_data,
+                                      const UlpLocation &location)
+{
+    loc_eng_geofence_data_s_type &data = loc_eng_data.geofence_data;
+
+    if (0 == data.count ||
+        !(location.gpsLocation.flags & GPS_LOCATION_HAS_LAT_LONG)) {
+        return;
+    }
+
+    int64_t now = ELAPSED_MILLIS_SINCE_BOOT_PLATFORM_LIB_ABSTRACTION;
+    data.fixSeq++;
+
+    int32_t latCell = geofence_cell(location.gpsLocation.latitude);
+    int32_t lonCell =
+        geofence_wrap_lon_cell(geofence_cell(location.gpsLocation.longitude));
+    for (loc_eng_geofence_cell_s_type* cell =
+             data.grid[geofence_cell_bucket(latCell, lonCell)];
+         NULL != cell; cell = cell->next) {
+        if (cell->latCell == latCell && cell->lonCell == lonCell) {
+            geofence_evaluate(data, cell->fence, location, now);
+        }
+    }
+
+    for (loc_eng_geofence_s_type* fence = data.wide; NULL != fence;
+         fence = fence->wideNext) {
+        geofence_evaluate(data, fence, location, now);
+    }
+
+    // a transition may take the fence off the list
+    loc_eng_geofence_s_type* next;
+    for (loc_eng_geofence_s_type* fence = data.active; NULL != fence;
+         fence = next) {
+        next = fence->activeNext;
+        geofence_evaluate(data, fence, location, now);
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_geofence_report_session
+
+DESCRIPTION
+   The engine only checks the fences against the fixes of the tracking
+   sessions the clients run, so it reports itself unavailable while no
+   session runs rather than let the fences silently never fire.
+
+DEPENDENCIES
+   Runs on the MsgTask, after the session state changes
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_eng_geofence_report_session(loc_eng_data_s_type &loc_eng_data)
+{
+    loc_eng_geofence_data_s_type &data = loc_eng_data.geofence_data;
+    bool available = loc_eng_data.adapter->isInSession();
+
+    if (!data.initialized || available == data.available) {
+        return;
+    }
+
+    data.available = available;
+    LOC_LOGD("%s: geofencing %s", __func__,
+             available ? "available" : "unavailable");
+    if (NULL != data.callbacks.geofence_status_callback) {
+        data.callbacks.geofence_status_callback(
+            available ? GPS_GEOFENCE_AVAILABLE : GPS_GEOFENCE_UNAVAILABLE,
+            NULL);
+    }
+}
+
+/*===========================================================================
+  Requests, all carried out on the MsgTask
+===========================================================================*/
+
+struct LocEngGeofenceInit : public LocMsg {
+    loc_eng_data_s_type* mLocEng;
+    const GpsGeofenceCallbacks mCallbacks;
+    inline LocEngGeofenceInit(loc_eng_data_s_type* locEng,
+                              const GpsGeofenceCallbacks& callbacks) :
+        LocMsg(), mLocEng(locEng), mCallbacks(callbacks)
+    {
+        locallog();
+    }
+    inline virtual void proc() const {
+        loc_eng_geofence_data_s_type &data = mLocEng->geofence_data;
+        data.callbacks = mCallbacks;
+        data.initialized = true;
+        data.available = mLocEng->adapter->isInSession();
+        if (NULL != data.callbacks.geofence_status_callback) {
+            data.callbacks.geofence_status_callback(
+                data.available ? GPS_GEOFENCE_AVAILABLE :
+                GPS_GEOFENCE_UNAVAILABLE, NULL);
+        }
+    }
+    inline void locallog() const {
+        LOC_LOGV("LocEngGeofenceInit");
+    }
+    inline virtual void log() const {
+        locallog();
+    }
+};
+
+struct LocEngGeofenceAdd : public LocMsg {
+    loc_eng_data_s_type* mLocEng;
+    const int32_t mId;
+    const double mLatitude;
+    const double mLongitude;
+    const double mRadius;
+    const int mLastTransition;
+    const int mMonitorTransitions;
+    inline LocEngGeofenceAdd(loc_eng_data_s_type* locEng, int32_t id,
+                             double latitude, double longitude,
+                             double radius, int lastTransition,
+                             int monitorTransitions) :
+        LocMsg(), mLocEng(locEng), mId(id), mLatitude(latitude),
+        mLongitude(longitude), mRadius(radius),
+        mLastTransition(lastTransition),
+        mMonitorTransitions(monitorTransitions)
+    {
+        locallog();
+    }
+    inline virtual void proc() const {
+        loc_eng_geofence_data_s_type &data = mLocEng->geofence_data;
+        int32_t status = GPS_GEOFENCE_OPERATION_SUCCESS;
+
+        if (NULL != geofence_find(data, mId)) {
+            status = GPS_GEOFENCE_ERROR_ID_EXISTS;
+        } else if (data.count >= LOC_ENG_GEOFENCE_MAX) {
+            status = GPS_GEOFENCE_ERROR_TOO_MANY_GEOFENCES;
+        } else if (mRadius <= 0 ||
+                   (mMonitorTransitions & ~(GPS_GEOFENCE_ENTERED |
+                                            GPS_GEOFENCE_EXITED |
+                                            GPS_GEOFENCE_UNCERTAIN))) {
+            status = GPS_GEOFENCE_ERROR_INVALID_TRANSITION;
+        } else {
+            loc_eng_geofence_s_type* fence = new loc_eng_geofence_s_type;
+            memset(fence, 0, sizeof(*fence));
+            fence->id = mId;
+            fence->latitude = mLatitude;
+            fence->longitude = mLongitude;
+            fence->radius = mRadius;
+            fence->monitorTransitions = mMonitorTransitions;
+            fence->state =
+                GPS_GEOFENCE_ENTERED == mLastTransition ?
+                LOC_ENG_GEOFENCE_STATE_INSIDE :
+                GPS_GEOFENCE_EXITED == mLastTransition ?
+                LOC_ENG_GEOFENCE_STATE_OUTSIDE :
+                LOC_ENG_GEOFENCE_STATE_UNKNOWN;
+            fence->pendingState = fence->state;
+            // not checked against any fix yet
+            fence->evalSeq = data.fixSeq - 2;
+
+            uint32_t bucket = geofence_id_bucket(mId);
+            fence->idNext = data.ids[bucket];
+            data.ids[bucket] = fence;
+            geofence_index(data, fence);
+            geofence_set_active(data, fence,
+                                LOC_ENG_GEOFENCE_STATE_OUTSIDE != fence->state);
+            data.count++;
+        }
+
+        if (NULL != data.callbacks.geofence_add_callback) {
+            data.callbacks.geofence_add_callback(mId, status);
+        }
+    }
+    inline void locallog() const {
+        LOC_LOGV("LocEngGeofenceAdd, id %d, %f, %f, radius %f, last %d, "
+                 "monitor %d", mId, mLatitude, mLongitude, mRadius,
+                 mLastTransition, mMonitorTransitions);
+    }
+    inline virtual void log() const {
+        locallog();
+    }
+};
+
+struct LocEngGeofenceRemove : public LocMsg {
+    loc_eng_data_s_type* mLocEng;
+    const int32_t mId;
+    inline LocEngGeofenceRemove(loc_eng_data_s_type* locEng, int32_t id) :
+        LocMsg(), mLocEng(locEng), mId(id)
+    {
+        locallog();
+    }
+    inline virtual void proc() const {
+        loc_eng_geofence_data_s_type &data = mLocEng->geofence_data;
+        int32_t status = GPS_GEOFENCE_ERROR_ID_UNKNOWN;
+
+        for (loc_eng_geofence_s_type** p = &data.ids[geofence_id_bucket(mId)];
+             NULL != *p; p = &(*p)->idNext) {
+            loc_eng_geofence_s_type* fence = *p;
+            if (fence->id == mId) {
+                *p = fence->idNext;
+                geofence_unindex(data, fence);
+                geofence_set_active(data, fence, false);
+                delete fence;
+                data.count--;
+                status = GPS_GEOFENCE_OPERATION_SUCCESS;
+                break;
+            }
+        }
+
+        if (NULL != data.callbacks.geofence_remove_callback) {
+            data.callbacks.geofence_remove_callback(mId, status);
+        }
+    }
+    inline void locallog() const {
+        LOC_LOGV("LocEngGeofenceRemove, id %d", mId);
+    }
+    inline virtual void log() const {
+        locallog();
+    }
+};
+
+struct LocEngGeofencePause : public LocMsg {
+    loc_eng_data_s_type* mLocEng;
+    const int32_t mId;
+    // -1 to pause, the transitions to monitor to resume
+    const int mMonitorTransitions;
+    inline LocEngGeofencePause(loc_eng_data_s_type* locEng, int32_t id,
+                               int monitorTransitions) :
+        LocMsg(), mLocEng(locEng), mId(id),
+        mMonitorTransitions(monitorTransitions)
+    {
+        locallog();
+    }
+    inline virtual void proc() const {
+        loc_eng_geofence_data_s_type &data = mLocEng->geofence_data;
+        loc_eng_geofence_s_type* fence = geofence_find(data, mId);
+        int32_t status = GPS_GEOFENCE_OPERATION_SUCCESS;
+        bool pause = mMonitorTransitions < 0;
+
+        if (NULL == fence) {
+            status = GPS_GEOFENCE_ERROR_ID_UNKNOWN;
+        } else if (pause) {
+            fence->paused = true;
+        } else {
+            fence->paused = false;
+            fence->monitorTransitions = mMonitorTransitions;
+        }
+
+        if (pause && NULL != data.callbacks.geofence_pause_callback) {
+            data.callbacks.geofence_pause_callback(mId, status);
+        } else if (!pause && NULL != data.callbacks.geofence_resume_callback) {
+            data.callbacks.geofence_resume_callback(mId, status);
+        }
+    }
+    inline void locallog() const {
+        LOC_LOGV("LocEngGeofencePause, id %d, monitor %d",
+                 mId, mMonitorTransitions);
+    }
+    inline virtual void log() const {
+        locallog();
+    }
+};
+
+/*===========================================================================
+FUNCTION    loc_eng_geofence_init
+
+DESCRIPTION
+   Initializes the in-tree geofence engine, used when no vendor geofence
+   library is present.
+
+DEPENDENCIES
+   loc_eng_init
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_eng_geofence_init(loc_eng_data_s_type &loc_eng_data,
+                           GpsGeofenceCallbacks* callbacks)
+{
+    ENTRY_LOG_CALLFLOW();
+    if (NULL == loc_eng_data.adapter) {
+        LOC_LOGE("%s: instance not initialized", __func__);
+        return;
+    }
+
+    if (NULL == callbacks) {
+        LOC_LOGE("%s: callbacks is NULL", __func__);
+    } else {
+        loc_eng_data.adapter->sendMsg(
+            new LocEngGeofenceInit(&loc_eng_data, *callbacks));
+    }
+
+    EXIT_LOG(%s, VOID_RET);
+}
+
+void loc_eng_geofence_add(loc_eng_data_s_type &loc_eng_data, int32_t id,
+                          double latitude, double longitude,
+                          double radius_meters, int last_transition,
+                          int monitor_transitions)
+{
+    ENTRY_LOG_CALLFLOW();
+    if (NULL == loc_eng_data.adapter) {
+        LOC_LOGE("%s: instance not initialized", __func__);
+        return;
+    }
+
+    loc_eng_data.adapter->sendMsg(
+        new LocEngGeofenceAdd(&loc_eng_data, id, latitude, longitude,
+                              radius_meters, last_transition,
+                              monitor_transitions));
+
+    EXIT_LOG(%s, VOID_RET);
+}
+
+void loc_eng_geofence_pause(loc_eng_data_s_type &loc_eng_data, int32_t id)
+{
+    ENTRY_LOG_CALLFLOW();
+    if (NULL == loc_eng_data.adapter) {
+        LOC_LOGE("%s: instance not initialized", __func__);
+        return;
+    }
+
+    loc_eng_data.adapter->sendMsg(
+        new LocEngGeofencePause(&loc_eng_data, id, -1));
+
+    EXIT_LOG(%s, VOID_RET);
+}
+
+void loc_eng_geofence_resume(loc_eng_data_s_type &loc_eng_data, int32_t id,
+                             int monitor_transitions)
+{
+    ENTRY_LOG_CALLFLOW();
+    if (NULL == loc_eng_data.adapter) {
+        LOC_LOGE("%s: instance not initialized", __func__);
+        return;
+    }
+
+    loc_eng_data.adapter->sendMsg(
+        new LocEngGeofencePause(&loc_eng_data, id, monitor_transitions));
+
+    EXIT_LOG(%s, VOID_RET);
+}
+
+void loc_eng_geofence_remove(loc_eng_data_s_type &loc_eng_data, int32_t id)
+{
+    ENTRY_LOG_CALLFLOW();
+    if (NULL == loc_eng_data.adapter) {
+        LOC_LOGE("%s: instance not initialized", __func__);
+        return;
+    }
+
+    loc_eng_data.adapter->sendMsg(new LocEngGeofenceRemove(&loc_eng_data, id));
+
+    EXIT_LOG(%s, VOID_RET);
+}
@@ -0,0 +1,106 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_ENG_GEOFENCE_H
+#define LOC_ENG_GEOFENCE_H
+
+#include <stdint.h>
+#include <hardware/gps.h>
+#include <gps_extended.h>
+
+// Most fences the engine keeps
+#define LOC_ENG_GEOFENCE_MAX          8192
+#define LOC_ENG_GEOFENCE_ID_BUCKETS   1024
+#define LOC_ENG_GEOFENCE_GRID_BUCKETS 4096
+// Grid cell size, about 1.1 km north-south
+#define LOC_ENG_GEOFENCE_CELL_DEG     0.01
+// Grid cells around the globe east-west
+#define LOC_ENG_GEOFENCE_LON_CELLS    36000
+// Fences spanning more cells than this are checked against every fix
+#define LOC_ENG_GEOFENCE_MAX_CELLS    64
+
+enum loc_eng_geofence_state_e_type {
+    LOC_ENG_GEOFENCE_STATE_UNKNOWN = 0,
+    LOC_ENG_GEOFENCE_STATE_INSIDE,
+    LOC_ENG_GEOFENCE_STATE_OUTSIDE
+};
+
+typedef struct loc_eng_geofence_s
+{
+    int32_t                        id;
+    double                         latitude;
+    double                         longitude;
+    double                         radius;
+    int                            monitorTransitions;
+    bool                           paused;
+    // in the list of wide fences rather than in the grid
+    bool                           wide;
+    // last reported state
+    loc_eng_geofence_state_e_type  state;
+    // state the recent fixes agree on, reported once held long enough
+    loc_eng_geofence_state_e_type  pendingState;
+    int64_t                        pendingSince;
+    // fix the fence was last checked against
+    uint32_t                       evalSeq;
+    struct loc_eng_geofence_s*     idNext;
+    // in the wide list
+    struct loc_eng_geofence_s*     wideNext;
+    // in the active list, fences not known to be outside
+    struct loc_eng_geofence_s*     activePrev;
+    struct loc_eng_geofence_s*     activeNext;
+    bool                           active;
+} loc_eng_geofence_s_type;
+
+// Membership of a fence in one grid cell
+typedef struct loc_eng_geofence_cell_s
+{
+    int32_t                        latCell;
+    int32_t                        lonCell;
+    loc_eng_geofence_s_type*       fence;
+    struct loc_eng_geofence_cell_s* next;
+} loc_eng_geofence_cell_s_type;
+
+// Module data, only touched on the MsgTask. Each fence is filed in the
+// grid cells its bounding box covers, so a fix is only checked against
+// the fences of its own cell, the wide ones and the active ones.
+typedef struct
+{
+    GpsGeofenceCallbacks           callbacks;
+    bool                           initialized;
+    // last reported status, available while a session runs
+    bool                           available;
+    int                            count;
+    uint32_t                       fixSeq;
+    loc_eng_geofence_s_type*       ids[LOC_ENG_GEOFENCE_ID_BUCKETS];
+    loc_eng_geofence_cell_s_type*  grid[LOC_ENG_GEOFENCE_GRID_BUCKETS];
+    loc_eng_geofence_s_type*       wide;
+    loc_eng_geofence_s_type*       active;
+} loc_eng_geofence_data_s_type;
+
+#endif // LOC_ENG_GEOFENCE_H
@@ -0,0 +1,186 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDDEBUG 0
+#define LOG_TAG "LocSvc_eng_inject_filter"
+
+#include <math.h>
+#include <string.h>
+#include <loc_eng.h>
+#include <loc_eng_inject_filter.h>
+#include "log_util.h"
+#include "platform_lib_includes.h"
+
+#define INJECT_FILTER_METERS_PER_DEGREE 111320.0
+
+// good enough at the distances that matter to a coarse position
+static double inject_filter_distance(double lat1, double lon1,
+                                     double lat2, double lon2)
+{
+    double dLon = lon2 - lon1;
+    if (dLon > 180.0) {
+        dLon -= 360.0;
+    } else if (dLon < -180.0) {
+        dLon += 360.0;
+    }
+    double dy = (lat2 - lat1) * INJECT_FILTER_METERS_PER_DEGREE;
+    double dx = dLon * INJECT_FILTER_METERS_PER_DEGREE *
+                cos((lat1 + lat2) * M_PI / 360.0);
+    return sqrt(dx * dx + dy * dy);
+}
+
+static void inject_filter_record(loc_eng_inject_filter_s_type &filter,
+                                 double latitude, double longitude,
+                                 float accuracy, int64_t now)
+{
+    if (filter.dropped) {
+        LOC_LOGV("%s: %u positions dropped", __func__, filter.dropped);
+    }
+
+    filter.injected = true;
+    filter.latitude = latitude;
+    filter.longitude = longitude;
+    filter.accuracy = accuracy;
+    filter.injectTime = now;
+    filter.pending = false;
+    filter.dropped = 0;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_inject_filter_check
+
+DESCRIPTION
+   Lets a coarse position through to the modem, with INJECT_FILTER, if it
+   is at least INJECT_MIN_DISTANCE meters away from the last one injected,
+   if its accuracy is better by as much, or if the last one is older than
+   INJECT_MAX_AGE msec. In a session, no more than one goes through every
+   INJECT_MIN_INTERVAL msec; the latest one held back for that is kept
+   pending for the next session start.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   true if the position is to be injected
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+bool loc_eng_inject_filter_check(loc_eng_inject_filter_s_type &filter,
+                                 double latitude, double longitude,
+                                 float accuracy, bool inSession)
+{
+    int64_t now = ELAPSED_MILLIS_SINCE_BOOT_PLATFORM_LIB_ABSTRACTION;
+
+    if (!gps_conf.INJECT_FILTER || !filter.injected) {
+        inject_filter_record(filter, latitude, longitude, accuracy, now);
+        return true;
+    }
+
+    int64_t age = now - filter.injectTime;
+    bool changed =
+        age >= (int64_t)gps_conf.INJECT_MAX_AGE ||
+        accuracy + (float)gps_conf.INJECT_MIN_DISTANCE <= filter.accuracy ||
+        inject_filter_distance(filter.latitude, filter.longitude,
+                               latitude, longitude) >=
+            (double)gps_conf.INJECT_MIN_DISTANCE;
+
+    if (!changed) {
+        // still close to what the modem has, an older pending one is stale
+        filter.pending = false;
+        filter.dropped++;
+        return false;
+    }
+
+    if (inSession && age < (int64_t)gps_conf.INJECT_MIN_INTERVAL) {
+        filter.pending = true;
+        filter.pendingLatitude = latitude;
+        filter.pendingLongitude = longitude;
+        filter.pendingAccuracy = accuracy;
+        filter.dropped++;
+        return false;
+    }
+
+    inject_filter_record(filter, latitude, longitude, accuracy, now);
+    return true;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_inject_filter_take_pending
+
+DESCRIPTION
+   Hands out the position held back for the rate, if any, and records it
+   as injected
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   true if there was one
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+bool loc_eng_inject_filter_take_pending(loc_eng_inject_filter_s_type &filter,
+                                        double &latitude, double &longitude,
+                                        float &accuracy)
+{
+    if (!filter.pending) {
+        return false;
+    }
+
+    latitude = filter.pendingLatitude;
+    longitude = filter.pendingLongitude;
+    accuracy = filter.pendingAccuracy;
+    inject_filter_record(filter, latitude, longitude, accuracy,
+                         ELAPSED_MILLIS_SINCE_BOOT_PLATFORM_LIB_ABSTRACTION);
+    return true;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_inject_filter_reset
+
+DESCRIPTION
+   Forgets what was injected, so that the next position goes through
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_eng_inject_filter_reset(loc_eng_inject_filter_s_type &filter)
+{
+    memset(&filter, 0, sizeof(filter));
+}
@@ -0,0 +1,63 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef LOC_ENG_INJECT_FILTER_H
+#define LOC_ENG_INJECT_FILTER_H
+
+#include <stdint.h>
+
+// Decides which coarse positions reach the modem, only touched on the MsgTask
+typedef struct
+{
+    // the last position injected
+    bool                           injected;
+    double                         latitude;
+    double                         longitude;
+    float                          accuracy;
+    // elapsed realtime of the last injection, in msec
+    int64_t                        injectTime;
+
+    // the latest position held back for the rate, injected at session start
+    bool                           pending;
+    double                         pendingLatitude;
+    double                         pendingLongitude;
+    float                          pendingAccuracy;
+
+    // positions dropped since the last injection
+    uint32_t                       dropped;
+} loc_eng_inject_filter_s_type;
+
+bool loc_eng_inject_filter_check(loc_eng_inject_filter_s_type &filter,
+                                 double latitude, double longitude,
+                                 float accuracy, bool inSession);
+bool loc_eng_inject_filter_take_pending(loc_eng_inject_filter_s_type &filter,
+                                        double &latitude, double &longitude,
+                                        float &accuracy);
+void loc_eng_inject_filter_reset(loc_eng_inject_filter_s_type &filter);
+
+#endif // LOC_ENG_INJECT_FILTER_H
@@ -114,6 +114,7 @@ struct LocEngReportSv : public LocMsg {
                    void* svExtended);
     virtual void proc() const;
     void locallog() const;
+    void logSvs() const;
     virtual void log() const;
     void send() const;
 };
@@ -0,0 +1,159 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define LOG_NDDEBUG 0
+#define LOG_TAG "LocSvc_eng_pos_cache"
+
+#include <string.h>
+#include <loc_eng.h>
+#include <loc_eng_pos_cache.h>
+#include "log_util.h"
+#include "platform_lib_includes.h"
+
+/*===========================================================================
+FUNCTION    loc_eng_pos_cache_add
+
+DESCRIPTION
+   Keeps a reported fix, overwriting the oldest one once the cache is full.
+   Only final fixes are kept. Intermediate fixes, which may be coarse, fixes
+   without a position and ZPP fixes, which may have come from this very
+   cache, are left out.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_eng_pos_cache_add(loc_eng_pos_cache_s_type &cache,
+                           const UlpLocation &location,
+                           const GpsLocationExtended &locationExtended,
+                           enum loc_sess_status status,
+                           LocPosTechMask techMask)
+{
+    if (LOC_SESS_SUCCESS != status ||
+        !(location.gpsLocation.flags & GPS_LOCATION_HAS_LAT_LONG) ||
+        ((location.gpsLocation.flags & LOCATION_HAS_SOURCE_INFO) &&
+         ULP_LOCATION_IS_FROM_ZPP == location.position_source)) {
+        return;
+    }
+
+    loc_eng_pos_cache_entry_s_type* entry = &cache.entries[cache.head];
+    entry->location = location;
+    // rawData is freed along with the report
+    entry->location.rawData = NULL;
+    entry->location.rawDataSize = 0;
+    entry->locationExtended = locationExtended;
+    entry->techMask = techMask;
+    entry->elapsedRealTime = ELAPSED_MILLIS_SINCE_BOOT_PLATFORM_LIB_ABSTRACTION;
+
+    cache.head = (cache.head + 1) % LOC_ENG_POS_CACHE_SIZE;
+    if (cache.count < LOC_ENG_POS_CACHE_SIZE) {
+        cache.count++;
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_pos_cache_get
+
+DESCRIPTION
+   Looks up the most recent fix no older than maxAgeMsec and, if maxAccuracy
+   is not 0, with an accuracy of maxAccuracy meters or better.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   true if a fix was found
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+bool loc_eng_pos_cache_get(const loc_eng_pos_cache_s_type &cache,
+                           int64_t maxAgeMsec, float maxAccuracy,
+                           UlpLocation &location,
+                           GpsLocationExtended &locationExtended,
+                           LocPosTechMask &techMask)
+{
+    int64_t now = ELAPSED_MILLIS_SINCE_BOOT_PLATFORM_LIB_ABSTRACTION;
+
+    for (int i = 1; i <= cache.count; i++) {
+        const loc_eng_pos_cache_entry_s_type* entry =
+            &cache.entries[(cache.head - i + LOC_ENG_POS_CACHE_SIZE) %
+                           LOC_ENG_POS_CACHE_SIZE];
+
+        if (now - entry->elapsedRealTime > maxAgeMsec) {
+            // the older ones are even more so
+            break;
+        }
+
+        if (maxAccuracy > 0 &&
+            (!(entry->location.gpsLocation.flags & GPS_LOCATION_HAS_ACCURACY) ||
+             entry->location.gpsLocation.accuracy > maxAccuracy)) {
+            continue;
+        }
+
+        location = entry->location;
+        locationExtended = entry->locationExtended;
+        techMask = entry->techMask;
+        LOC_LOGD("%s: hit, %lld msec old, accuracy %f", __func__,
+                 now - entry->elapsedRealTime,
+                 entry->location.gpsLocation.accuracy);
+        return true;
+    }
+
+    LOC_LOGD("%s: miss, %d fixes cached", __func__, cache.count);
+    return false;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_pos_cache_clear
+
+DESCRIPTION
+   Forgets all the cached fixes.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_eng_pos_cache_clear(loc_eng_pos_cache_s_type &cache)
+{
+    memset(&cache, 0, sizeof(cache));
+}
@@ -0,0 +1,69 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_ENG_POS_CACHE_H
+#define LOC_ENG_POS_CACHE_H
+
+#include <stdint.h>
+#include <gps_extended.h>
+
+// Number of recent fixes kept for ZPP requests
+#define LOC_ENG_POS_CACHE_SIZE 8
+
+typedef struct
+{
+    UlpLocation                    location;
+    GpsLocationExtended            locationExtended;
+    LocPosTechMask                 techMask;
+    // elapsed realtime of the report, in msec
+    int64_t                        elapsedRealTime;
+} loc_eng_pos_cache_entry_s_type;
+
+// Ring of the recent fixes, only touched on the MsgTask
+typedef struct
+{
+    loc_eng_pos_cache_entry_s_type entries[LOC_ENG_POS_CACHE_SIZE];
+    // next entry to write
+    int                            head;
+    int                            count;
+} loc_eng_pos_cache_s_type;
+
+void loc_eng_pos_cache_add(loc_eng_pos_cache_s_type &cache,
+                           const UlpLocation &location,
+                           const GpsLocationExtended &locationExtended,
+                           enum loc_sess_status status,
+                           LocPosTechMask techMask);
+bool loc_eng_pos_cache_get(const loc_eng_pos_cache_s_type &cache,
+                           int64_t maxAgeMsec, float maxAccuracy,
+                           UlpLocation &location,
+                           GpsLocationExtended &locationExtended,
+                           LocPosTechMask &techMask);
+void loc_eng_pos_cache_clear(loc_eng_pos_cache_s_type &cache);
+
+#endif // LOC_ENG_POS_CACHE_H
@@ -0,0 +1,135 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define LOG_NDDEBUG 0
+#define LOG_TAG "LocSvc_eng_sv_filter"
+
+#include <math.h>
+#include <string.h>
+#include <loc_eng.h>
+#include <loc_eng_sv_filter.h>
+#include "log_util.h"
+#include "platform_lib_includes.h"
+
+static inline float sv_filter_quantize(float value, unsigned long step)
+{
+    return step ? floorf(value / step) : value;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_sv_filter_check
+
+DESCRIPTION
+   Lets an sv report through if it differs from the last one let through,
+   with SV_REPORT_SUPPRESS, and if SV_REPORT_MIN_INTERVAL msec have passed
+   since. The sv set, the masks, and the snr, elevation and azimuth
+   quantized to SV_REPORT_SNR_STEP dB and SV_REPORT_ANGLE_STEP degrees
+   are compared. A report held back for the rate is not recorded, so the
+   next one after the interval still counts as changed and carries the
+   latest state.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   true if the report is to be delivered
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+bool loc_eng_sv_filter_check(loc_eng_sv_filter_s_type &filter,
+                             const GpsSvStatus &svStatus)
+{
+    int numSvs = svStatus.num_svs < GPS_MAX_SVS ?
+                 svStatus.num_svs : GPS_MAX_SVS;
+    loc_eng_sv_filter_entry_s_type svs[GPS_MAX_SVS];
+
+    for (int i = 0; i < numSvs; i++) {
+        const GpsSvInfo &sv = svStatus.sv_list[i];
+        svs[i].prn = sv.prn;
+        svs[i].snr = sv_filter_quantize(sv.snr, gps_conf.SV_REPORT_SNR_STEP);
+        svs[i].elevation = sv_filter_quantize(sv.elevation,
+                                              gps_conf.SV_REPORT_ANGLE_STEP);
+        svs[i].azimuth = sv_filter_quantize(sv.azimuth,
+                                            gps_conf.SV_REPORT_ANGLE_STEP);
+    }
+
+    if (filter.reported && gps_conf.SV_REPORT_SUPPRESS &&
+        numSvs == filter.numSvs &&
+        svStatus.ephemeris_mask == filter.ephemerisMask &&
+        svStatus.almanac_mask == filter.almanacMask &&
+        svStatus.used_in_fix_mask == filter.usedInFixMask &&
+        0 == memcmp(svs, filter.svs, numSvs * sizeof(svs[0]))) {
+        filter.suppressed++;
+        return false;
+    }
+
+    int64_t now = ELAPSED_MILLIS_SINCE_BOOT_PLATFORM_LIB_ABSTRACTION;
+    if (filter.reported &&
+        now - filter.lastReportTime < (int64_t)gps_conf.SV_REPORT_MIN_INTERVAL) {
+        filter.suppressed++;
+        return false;
+    }
+
+    if (filter.suppressed) {
+        LOC_LOGV("%s: %u sv reports held back", __func__, filter.suppressed);
+    }
+
+    filter.reported = true;
+    filter.numSvs = numSvs;
+    filter.ephemerisMask = svStatus.ephemeris_mask;
+    filter.almanacMask = svStatus.almanac_mask;
+    filter.usedInFixMask = svStatus.used_in_fix_mask;
+    memcpy(filter.svs, svs, numSvs * sizeof(svs[0]));
+    filter.lastReportTime = now;
+    filter.suppressed = 0;
+    return true;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_sv_filter_reset
+
+DESCRIPTION
+   Lets the next sv report through whatever it looks like
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_eng_sv_filter_reset(loc_eng_sv_filter_s_type &filter)
+{
+    memset(&filter, 0, sizeof(filter));
+}
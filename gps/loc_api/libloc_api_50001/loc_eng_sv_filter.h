@@ -0,0 +1,64 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_ENG_SV_FILTER_H
+#define LOC_ENG_SV_FILTER_H
+
+#include <stdint.h>
+#include <hardware/gps.h>
+
+// What an sv looked like in the last report let through, quantized
+typedef struct
+{
+    int                            prn;
+    float                          snr;
+    float                          elevation;
+    float                          azimuth;
+} loc_eng_sv_filter_entry_s_type;
+
+// Decides which sv reports reach sv_status_cb, only touched on the MsgTask
+typedef struct
+{
+    bool                           reported;
+    int                            numSvs;
+    uint32_t                       ephemerisMask;
+    uint32_t                       almanacMask;
+    uint32_t                       usedInFixMask;
+    loc_eng_sv_filter_entry_s_type svs[GPS_MAX_SVS];
+    // elapsed realtime of the last report let through, in msec
+    int64_t                        lastReportTime;
+    // reports held back since the last one let through
+    uint32_t                       suppressed;
+} loc_eng_sv_filter_s_type;
+
+bool loc_eng_sv_filter_check(loc_eng_sv_filter_s_type &filter,
+                             const GpsSvStatus &svStatus);
+void loc_eng_sv_filter_reset(loc_eng_sv_filter_s_type &filter);
+
+#endif // LOC_ENG_SV_FILTER_H
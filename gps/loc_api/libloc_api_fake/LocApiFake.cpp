@@ -0,0 +1,562 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDDEBUG 0
+#define LOG_TAG "LocSvc_ApiFake"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <LocApiFake.h>
+#include <loc_cfg.h>
+#include <log_util.h>
+
+#ifndef GPS_CONF_FILE
+#define GPS_CONF_FILE            "/etc/gps.conf"
+#endif
+
+#define FAKE_SCRIPT_MAX          64
+// fixes remembered for loc_api_fake_gen_time()
+#define FAKE_GEN_RING_SIZE       64
+#define FAKE_NUM_SVS             8
+#define FAKE_METERS_PER_DEGREE   111320.0
+
+struct LocApiFake::ScriptStep {
+    // offset from the session start
+    uint32_t at_ms;
+    enum {
+        XTRA,
+        TIME,
+        LOCATION,
+        ATL,
+        STATUS
+    } event;
+    int arg;
+};
+
+static struct {
+    uint32_t FAKE_POS_RATE_HZ;
+    uint32_t FAKE_SV_RATE_HZ;
+    uint32_t FAKE_NMEA_RATE_HZ;
+    double FAKE_LATITUDE;
+    double FAKE_LONGITUDE;
+    double FAKE_SPEED;
+    char FAKE_SCRIPT[LOC_MAX_PARAM_STRING + 1];
+} fake_conf;
+
+static loc_param_s_type fake_parameter_table[] =
+{
+  {"FAKE_POS_RATE_HZ",               &fake_conf.FAKE_POS_RATE_HZ,              NULL, 'n'},
+  {"FAKE_SV_RATE_HZ",                &fake_conf.FAKE_SV_RATE_HZ,               NULL, 'n'},
+  {"FAKE_NMEA_RATE_HZ",              &fake_conf.FAKE_NMEA_RATE_HZ,             NULL, 'n'},
+  {"FAKE_LATITUDE",                  &fake_conf.FAKE_LATITUDE,                 NULL, 'f'},
+  {"FAKE_LONGITUDE",                 &fake_conf.FAKE_LONGITUDE,                NULL, 'f'},
+  {"FAKE_SPEED",                     &fake_conf.FAKE_SPEED,                    NULL, 'f'},
+  {"FAKE_SCRIPT",                    &fake_conf.FAKE_SCRIPT,                   NULL, 's'},
+};
+
+static struct {
+    GpsUtcTime timestamp;
+    int64_t gen_ns;
+} gen_ring[FAKE_GEN_RING_SIZE];
+static pthread_mutex_t gen_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int64_t fake_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int64_t fake_period_ns(uint32_t rate_hz)
+{
+    return rate_hz ? 1000000000LL / rate_hz : 0;
+}
+
+extern "C" int64_t loc_api_fake_gen_time(GpsUtcTime timestamp)
+{
+    int64_t gen_ns = 0;
+    int i = timestamp % FAKE_GEN_RING_SIZE;
+
+    pthread_mutex_lock(&gen_lock);
+    if (gen_ring[i].timestamp == timestamp) {
+        gen_ns = gen_ring[i].gen_ns;
+    }
+    pthread_mutex_unlock(&gen_lock);
+
+    return gen_ns;
+}
+
+LocApiFake::LocApiFake(const MsgTask* msgTask,
+                       LOC_API_ADAPTER_EVENT_MASK_T exMask) :
+    LocApiBase(msgTask, exMask),
+    mThreadStarted(false), mInSession(false), mExit(false),
+    mSessionId(0), mFixInterval(0),
+    mLastTimestamp(0), mScript(NULL), mScriptLen(0)
+{
+    fake_conf.FAKE_POS_RATE_HZ = 0;
+    fake_conf.FAKE_SV_RATE_HZ = 1;
+    fake_conf.FAKE_NMEA_RATE_HZ = 0;
+    fake_conf.FAKE_LATITUDE = 37.422;
+    fake_conf.FAKE_LONGITUDE = -122.084;
+    fake_conf.FAKE_SPEED = 0;
+    fake_conf.FAKE_SCRIPT[0] = '\0';
+    UTIL_READ_CONF(GPS_CONF_FILE, fake_parameter_table);
+
+    mLatitude = fake_conf.FAKE_LATITUDE;
+    mLongitude = fake_conf.FAKE_LONGITUDE;
+    if ('\0' != fake_conf.FAKE_SCRIPT[0]) {
+        loadScript(fake_conf.FAKE_SCRIPT);
+    }
+
+    pthread_mutex_init(&mLock, NULL);
+    pthread_cond_init(&mCond, NULL);
+    int err = pthread_create(&mThread, NULL, threadMain, this);
+    if (err) {
+        LOC_LOGE("%s:%d]: failed to create generator thread: %d",
+                 __func__, __LINE__, err);
+    } else {
+        mThreadStarted = true;
+    }
+
+    LOC_LOGD("%s:%d]: pos %u Hz, sv %u Hz, nmea %u Hz, %d script steps",
+             __func__, __LINE__, fake_conf.FAKE_POS_RATE_HZ,
+             fake_conf.FAKE_SV_RATE_HZ, fake_conf.FAKE_NMEA_RATE_HZ,
+             mScriptLen);
+}
+
+LocApiFake::~LocApiFake()
+{
+    pthread_mutex_lock(&mLock);
+    mExit = true;
+    pthread_cond_signal(&mCond);
+    pthread_mutex_unlock(&mLock);
+
+    if (mThreadStarted) {
+        pthread_join(mThread, NULL);
+    }
+
+    pthread_cond_destroy(&mCond);
+    pthread_mutex_destroy(&mLock);
+    delete[] mScript;
+}
+
+/*===========================================================================
+FUNCTION    loadScript
+
+DESCRIPTION
+   Reads the scripted requests, one "<ms> <event> [arg]" per line, where
+   the event is one of xtra, time, location, atl <agps type> or
+   status <GpsStatusValue>. Lines starting with '#' are skipped.
+
+DEPENDENCIES
+   None
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void LocApiFake::loadScript(const char* path)
+{
+    FILE* fp = fopen(path, "r");
+    if (NULL == fp) {
+        LOC_LOGE("%s:%d]: failed to open %s: %d",
+                 __func__, __LINE__, path, errno);
+        return;
+    }
+
+    mScript = new ScriptStep[FAKE_SCRIPT_MAX];
+    char line[LOC_MAX_PARAM_LINE];
+    while (mScriptLen < FAKE_SCRIPT_MAX && NULL != fgets(line, sizeof(line), fp)) {
+        ScriptStep& step = mScript[mScriptLen];
+        char event[16];
+        unsigned int at_ms;
+        int arg = 0;
+
+        if ('#' == line[0] ||
+            sscanf(line, "%u %15s %d", &at_ms, event, &arg) < 2) {
+            continue;
+        }
+
+        if (0 == strcmp(event, "xtra")) {
+            step.event = ScriptStep::XTRA;
+        } else if (0 == strcmp(event, "time")) {
+            step.event = ScriptStep::TIME;
+        } else if (0 == strcmp(event, "location")) {
+            step.event = ScriptStep::LOCATION;
+        } else if (0 == strcmp(event, "atl")) {
+            step.event = ScriptStep::ATL;
+        } else if (0 == strcmp(event, "status")) {
+            step.event = ScriptStep::STATUS;
+        } else {
+            LOC_LOGW("%s:%d]: unknown event %s", __func__, __LINE__, event);
+            continue;
+        }
+        step.at_ms = at_ms;
+        step.arg = arg;
+        mScriptLen++;
+    }
+    fclose(fp);
+}
+
+void LocApiFake::runStep(const ScriptStep& step)
+{
+    static int connHandle = 0;
+
+    LOC_LOGV("%s:%d]: %u ms event %d", __func__, __LINE__,
+             step.at_ms, step.event);
+    switch (step.event) {
+    case ScriptStep::XTRA:
+        requestXtraData();
+        break;
+    case ScriptStep::TIME:
+        requestTime();
+        break;
+    case ScriptStep::LOCATION:
+        requestLocation();
+        break;
+    case ScriptStep::ATL:
+        requestATL(++connHandle, (AGpsType)step.arg);
+        break;
+    case ScriptStep::STATUS:
+        reportStatus((GpsStatusValue)step.arg);
+        break;
+    }
+}
+
+void LocApiFake::synthPosition(int64_t now, int64_t period)
+{
+    UlpLocation location;
+    GpsLocationExtended locationExtended;
+    struct timespec ts;
+
+    memset(&location, 0, sizeof(location));
+    memset(&locationExtended, 0, sizeof(locationExtended));
+    location.size = sizeof(location);
+    locationExtended.size = sizeof(locationExtended);
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    GpsUtcTime timestamp = (GpsUtcTime)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    // the benchmark looks fixes up by timestamp, keep them unique
+    if (timestamp <= mLastTimestamp) {
+        timestamp = mLastTimestamp + 1;
+    }
+    mLastTimestamp = timestamp;
+
+    // heading north at FAKE_SPEED
+    pthread_mutex_lock(&mLock);
+    mLatitude += fake_conf.FAKE_SPEED * period / 1e9 / FAKE_METERS_PER_DEGREE;
+    double latitude = mLatitude;
+    double longitude = mLongitude;
+    pthread_mutex_unlock(&mLock);
+
+    location.position_source = ULP_LOCATION_IS_FROM_GNSS;
+    location.gpsLocation.size = sizeof(location.gpsLocation);
+    location.gpsLocation.flags = GPS_LOCATION_HAS_LAT_LONG |
+                                 GPS_LOCATION_HAS_ALTITUDE |
+                                 GPS_LOCATION_HAS_SPEED |
+                                 GPS_LOCATION_HAS_BEARING |
+                                 GPS_LOCATION_HAS_ACCURACY;
+    location.gpsLocation.latitude = latitude;
+    location.gpsLocation.longitude = longitude;
+    location.gpsLocation.altitude = 10;
+    location.gpsLocation.speed = fake_conf.FAKE_SPEED;
+    location.gpsLocation.bearing = 0;
+    location.gpsLocation.accuracy = 5;
+    location.gpsLocation.timestamp = timestamp;
+
+    locationExtended.flags = GPS_LOCATION_EXTENDED_HAS_DOP;
+    locationExtended.pdop = 1.5;
+    locationExtended.hdop = 1.0;
+    locationExtended.vdop = 1.1;
+
+    pthread_mutex_lock(&gen_lock);
+    gen_ring[timestamp % FAKE_GEN_RING_SIZE].timestamp = timestamp;
+    gen_ring[timestamp % FAKE_GEN_RING_SIZE].gen_ns = now;
+    pthread_mutex_unlock(&gen_lock);
+
+    reportPosition(location, locationExtended, NULL, LOC_SESS_SUCCESS,
+                   LOC_POS_TECH_MASK_SATELLITE);
+}
+
+void LocApiFake::synthSv()
+{
+    GpsSvStatus svStatus;
+    GpsLocationExtended locationExtended;
+
+    memset(&svStatus, 0, sizeof(svStatus));
+    memset(&locationExtended, 0, sizeof(locationExtended));
+    svStatus.size = sizeof(svStatus);
+    locationExtended.size = sizeof(locationExtended);
+
+    svStatus.num_svs = FAKE_NUM_SVS;
+    for (int i = 0; i < FAKE_NUM_SVS; i++) {
+        GpsSvInfo& sv = svStatus.sv_list[i];
+        sv.size = sizeof(sv);
+        sv.prn = 2 * i + 1;
+        sv.snr = 20 + 3 * i;
+        sv.elevation = 10 + 10 * i;
+        sv.azimuth = 45 * i;
+        svStatus.ephemeris_mask |= 1 << (sv.prn - 1);
+        svStatus.almanac_mask |= 1 << (sv.prn - 1);
+        if (i < FAKE_NUM_SVS - 2) {
+            svStatus.used_in_fix_mask |= 1 << (sv.prn - 1);
+        }
+    }
+
+    reportSv(svStatus, locationExtended, NULL);
+}
+
+void LocApiFake::synthNmea()
+{
+    char nmea[128];
+    struct timespec ts;
+    struct tm utc;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    gmtime_r(&ts.tv_sec, &utc);
+
+    pthread_mutex_lock(&mLock);
+    double latitude = mLatitude;
+    double longitude = mLongitude;
+    pthread_mutex_unlock(&mLock);
+
+    double lat = fabs(latitude);
+    double lon = fabs(longitude);
+    int len = snprintf(nmea, sizeof(nmea),
+                       "$GPGGA,%02d%02d%02d.%02ld,%02d%07.4f,%c,%03d%07.4f,%c,1,%02d,1.0,10.0,M,,M,,",
+                       utc.tm_hour, utc.tm_min, utc.tm_sec,
+                       ts.tv_nsec / 10000000,
+                       (int)lat, (lat - (int)lat) * 60,
+                       latitude < 0 ? 'S' : 'N',
+                       (int)lon, (lon - (int)lon) * 60,
+                       longitude < 0 ? 'W' : 'E',
+                       FAKE_NUM_SVS - 2);
+
+    unsigned char checksum = 0;
+    for (int i = 1; i < len; i++) {
+        checksum ^= nmea[i];
+    }
+    len += snprintf(nmea + len, sizeof(nmea) - len, "*%02X\r\n", checksum);
+
+    reportNmea(nmea, len);
+}
+
+void* LocApiFake::threadMain(void* arg)
+{
+    ((LocApiFake*)arg)->run();
+    return NULL;
+}
+
+void LocApiFake::run()
+{
+    uint32_t sessionId = 0;
+    int64_t start = 0;
+    int64_t posPeriod = 0;
+    int64_t svPeriod = fake_period_ns(fake_conf.FAKE_SV_RATE_HZ);
+    int64_t nmeaPeriod = fake_period_ns(fake_conf.FAKE_NMEA_RATE_HZ);
+    int64_t nextPos = 0, nextSv = 0, nextNmea = 0;
+    int nextStep = 0;
+
+    pthread_mutex_lock(&mLock);
+    while (!mExit) {
+        if (!mInSession) {
+            pthread_cond_wait(&mCond, &mLock);
+            continue;
+        }
+
+        int64_t now = fake_now_ns();
+        if (sessionId != mSessionId) {
+            // a new session, restart the schedule
+            sessionId = mSessionId;
+            start = now;
+            posPeriod = fake_conf.FAKE_POS_RATE_HZ ?
+                        fake_period_ns(fake_conf.FAKE_POS_RATE_HZ) :
+                        (int64_t)mFixInterval * 1000000;
+            nextPos = nextSv = nextNmea = now;
+            nextStep = 0;
+        }
+
+        // reports are delivered without the lock, adapters may call back
+        // into startFix()/stopFix() from them
+        pthread_mutex_unlock(&mLock);
+        if (posPeriod && now >= nextPos) {
+            synthPosition(now, posPeriod);
+            nextPos += posPeriod;
+        }
+        if (svPeriod && now >= nextSv) {
+            synthSv();
+            nextSv += svPeriod;
+        }
+        if (nmeaPeriod && now >= nextNmea) {
+            synthNmea();
+            nextNmea += nmeaPeriod;
+        }
+        while (nextStep < mScriptLen &&
+               now - start >= (int64_t)mScript[nextStep].at_ms * 1000000) {
+            runStep(mScript[nextStep++]);
+        }
+        pthread_mutex_lock(&mLock);
+
+        // sleep until whatever is due next, 0 if nothing is
+        int64_t next = 0;
+        if (posPeriod && (!next || nextPos < next)) next = nextPos;
+        if (svPeriod && (!next || nextSv < next)) next = nextSv;
+        if (nmeaPeriod && (!next || nextNmea < next)) next = nextNmea;
+        if (nextStep < mScriptLen) {
+            int64_t at = start + (int64_t)mScript[nextStep].at_ms * 1000000;
+            if (!next || at < next) next = at;
+        }
+        if (0 == next) {
+            if (!mExit && sessionId == mSessionId) {
+                pthread_cond_wait(&mCond, &mLock);
+            }
+            continue;
+        }
+
+        int64_t wait = next - fake_now_ns();
+        if (wait > 0 && !mExit && sessionId == mSessionId) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            wait += deadline.tv_nsec;
+            deadline.tv_sec += wait / 1000000000;
+            deadline.tv_nsec = wait % 1000000000;
+            pthread_cond_timedwait(&mCond, &mLock, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+enum loc_api_adapter_err
+LocApiFake::startFix(const LocPosMode& posMode)
+{
+    LOC_LOGD("%s:%d]: interval %u ms", __func__, __LINE__,
+             posMode.min_interval);
+
+    pthread_mutex_lock(&mLock);
+    mFixInterval = posMode.min_interval;
+    mInSession = true;
+    mSessionId++;
+    pthread_cond_signal(&mCond);
+    pthread_mutex_unlock(&mLock);
+
+    reportStatus(GPS_STATUS_SESSION_BEGIN);
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+enum loc_api_adapter_err
+LocApiFake::stopFix()
+{
+    LOC_LOGD("%s:%d]: ", __func__, __LINE__);
+
+    pthread_mutex_lock(&mLock);
+    mInSession = false;
+    mSessionId++;
+    pthread_cond_signal(&mCond);
+    pthread_mutex_unlock(&mLock);
+
+    reportStatus(GPS_STATUS_SESSION_END);
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+enum loc_api_adapter_err
+LocApiFake::injectPosition(double latitude, double longitude, float accuracy)
+{
+    LOC_LOGD("%s:%d]: %f, %f, %f", __func__, __LINE__,
+             latitude, longitude, accuracy);
+
+    // the next fixes start from the injected position
+    pthread_mutex_lock(&mLock);
+    mLatitude = latitude;
+    mLongitude = longitude;
+    pthread_mutex_unlock(&mLock);
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+enum loc_api_adapter_err
+LocApiFake::setXtraData(char* data, int length)
+{
+    LOC_LOGD("%s:%d]: %d bytes", __func__, __LINE__, length);
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+enum loc_api_adapter_err
+LocApiFake::atlOpenStatus(int handle, int is_succ, char* apn,
+                          ApnIpType bear, AGpsType agpsType)
+{
+    LOC_LOGD("%s:%d]: handle %d, succ %d, apn %s, type %d",
+             __func__, __LINE__, handle, is_succ,
+             NULL != apn ? apn : "", agpsType);
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+enum loc_api_adapter_err
+LocApiFake::atlCloseStatus(int handle, int is_succ)
+{
+    LOC_LOGD("%s:%d]: handle %d, succ %d", __func__, __LINE__,
+             handle, is_succ);
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+enum loc_api_adapter_err
+LocApiFake::getZppFix(GpsLocation & zppLoc)
+{
+    LocPosTechMask tech_mask;
+    return getZppFix(zppLoc, tech_mask);
+}
+
+enum loc_api_adapter_err
+LocApiFake::getZppFix(GpsLocation & zppLoc, LocPosTechMask & tech_mask)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    memset(&zppLoc, 0, sizeof(zppLoc));
+    zppLoc.size = sizeof(zppLoc);
+    zppLoc.flags = GPS_LOCATION_HAS_LAT_LONG | GPS_LOCATION_HAS_ACCURACY;
+    pthread_mutex_lock(&mLock);
+    zppLoc.latitude = mLatitude;
+    zppLoc.longitude = mLongitude;
+    pthread_mutex_unlock(&mLock);
+    zppLoc.accuracy = 50;
+    zppLoc.timestamp = (GpsUtcTime)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    tech_mask = LOC_POS_TECH_MASK_CELLID;
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+extern "C" LocApiBase* getLocApi(const MsgTask* msgTask,
+                                 LOC_API_ADAPTER_EVENT_MASK_T exMask)
+{
+    return new LocApiFake(msgTask, exMask);
+}
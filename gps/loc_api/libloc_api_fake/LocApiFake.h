@@ -0,0 +1,102 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef LOC_API_FAKE_H
+#define LOC_API_FAKE_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <LocApiBase.h>
+
+using namespace loc_core;
+
+// Stand-in for the modem LocApi, picked up by ContextBase::createLocApi()
+// when no vendor library is present and debug.gps.fake_loc_api is 1.
+// While a session runs it synthesizes position, SV, NMEA and status
+// reports at the rates set in gps.conf, and replays scripted
+// AGPS/XTRA/time requests, so the HAL and everything above it can be
+// exercised without a modem.
+class LocApiFake : public LocApiBase {
+public:
+    LocApiFake(const MsgTask* msgTask,
+               LOC_API_ADAPTER_EVENT_MASK_T exMask);
+    virtual ~LocApiFake();
+
+    virtual enum loc_api_adapter_err
+        startFix(const LocPosMode& posMode);
+    virtual enum loc_api_adapter_err
+        stopFix();
+    virtual enum loc_api_adapter_err
+        injectPosition(double latitude, double longitude, float accuracy);
+    virtual enum loc_api_adapter_err
+        setXtraData(char* data, int length);
+    virtual enum loc_api_adapter_err
+        atlOpenStatus(int handle, int is_succ, char* apn, ApnIpType bear,
+                      AGpsType agpsType);
+    virtual enum loc_api_adapter_err
+        atlCloseStatus(int handle, int is_succ);
+    virtual enum loc_api_adapter_err
+        getZppFix(GpsLocation & zppLoc);
+    virtual enum loc_api_adapter_err
+        getZppFix(GpsLocation & zppLoc, LocPosTechMask & tech_mask);
+
+private:
+    struct ScriptStep;
+
+    pthread_mutex_t mLock;
+    pthread_cond_t mCond;
+    pthread_t mThread;
+    bool mThreadStarted;
+    bool mInSession;
+    bool mExit;
+    // bumped by every startFix so the generator restarts its schedule
+    uint32_t mSessionId;
+    uint32_t mFixInterval;
+
+    double mLatitude;
+    double mLongitude;
+    GpsUtcTime mLastTimestamp;
+
+    ScriptStep* mScript;
+    int mScriptLen;
+
+    static void* threadMain(void* arg);
+    void run();
+    void loadScript(const char* path);
+    void runStep(const ScriptStep& step);
+    void synthPosition(int64_t now, int64_t period);
+    void synthSv();
+    void synthNmea();
+};
+
+// boot time in nsec at which the fix with this timestamp was generated,
+// 0 if it is not one of the recent ones; used by loc_api_bench
+extern "C" int64_t loc_api_fake_gen_time(GpsUtcTime timestamp);
+
+#endif // LOC_API_FAKE_H
@@ -0,0 +1,272 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDDEBUG 0
+#define LOG_TAG "LocSvc_bench"
+
+#include <dlfcn.h>
+#include <new>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <hardware/gps.h>
+
+// Drives the whole location stack, gps HAL -> LocEngAdapter -> LocApi,
+// against the fake LocApi, which has to be installed, with
+// debug.gps.fake_loc_api set to 1, so that ContextBase::createLocApi()
+// picks it up. The MsgTask throughput is counted by the MsgTasks
+// themselves, since batching and the sv filter keep some messages from
+// reaching the GpsCallbacks. Allocations are counted through operator
+// new, malloc() from C code is not included.
+
+#define BENCH_MAX_FIXES 100000
+
+typedef int64_t (gen_time_t)(GpsUtcTime timestamp);
+typedef uint32_t (msgs_processed_t)();
+
+static volatile uint32_t allocs;
+static gen_time_t* gen_time;
+static msgs_processed_t* msgs_processed;
+
+static pthread_mutex_t bench_lock = PTHREAD_MUTEX_INITIALIZER;
+static int64_t latencies[BENCH_MAX_FIXES];
+static int num_fixes;
+static int num_unmatched;
+static uint32_t num_status, num_sv, num_nmea;
+static uint32_t allocs_at_start;
+
+void* operator new(size_t size)
+{
+    __sync_fetch_and_add(&allocs, 1);
+    void* p = malloc(size ? size : 1);
+    if (NULL == p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
+
+static int64_t bench_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void location_cb(GpsLocation* location)
+{
+    int64_t now = bench_now_ns();
+    int64_t gen = gen_time ? gen_time(location->timestamp) : 0;
+
+    pthread_mutex_lock(&bench_lock);
+    if (0 == gen) {
+        num_unmatched++;
+    } else if (num_fixes < BENCH_MAX_FIXES) {
+        latencies[num_fixes++] = now - gen;
+    }
+    pthread_mutex_unlock(&bench_lock);
+}
+
+static void status_cb(GpsStatus* status)
+{
+    __sync_fetch_and_add(&num_status, 1);
+}
+
+static void sv_status_cb(GpsSvStatus* sv_info)
+{
+    __sync_fetch_and_add(&num_sv, 1);
+}
+
+static void nmea_cb(GpsUtcTime timestamp, const char* nmea, int length)
+{
+    __sync_fetch_and_add(&num_nmea, 1);
+}
+
+static void set_capabilities_cb(uint32_t capabilities)
+{
+}
+
+static void acquire_wakelock_cb()
+{
+}
+
+static void release_wakelock_cb()
+{
+}
+
+static void request_utc_time_cb()
+{
+}
+
+static pthread_t create_thread_cb(const char* name, void (*start)(void *),
+                                  void* arg)
+{
+    pthread_t thread;
+
+    if (pthread_create(&thread, NULL, (void* (*)(void*))start, arg)) {
+        fprintf(stderr, "failed to create thread %s\n", name);
+        return 0;
+    }
+    return thread;
+}
+
+static GpsCallbacks callbacks = {
+    sizeof(GpsCallbacks),
+    location_cb,
+    status_cb,
+    sv_status_cb,
+    nmea_cb,
+    set_capabilities_cb,
+    acquire_wakelock_cb,
+    release_wakelock_cb,
+    create_thread_cb,
+    request_utc_time_cb,
+};
+
+static int compare_int64(const void* a, const void* b)
+{
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static double percentile_us(int p)
+{
+    if (0 == num_fixes) {
+        return 0;
+    }
+    return latencies[(num_fixes - 1) * p / 100] / 1000.0;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-d seconds] [-i interval ms]\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    int duration = 10;
+    int interval = 1000;
+    int opt;
+
+    while (-1 != (opt = getopt(argc, argv, "d:i:"))) {
+        switch (opt) {
+        case 'd':
+            duration = atoi(optarg);
+            break;
+        case 'i':
+            interval = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // same handle as the one loaded by ContextBase
+    void* fake = dlopen("libloc_api_fake.so", RTLD_NOW);
+    if (NULL != fake) {
+        gen_time = (gen_time_t*)dlsym(fake, "loc_api_fake_gen_time");
+    }
+    if (NULL == gen_time) {
+        fprintf(stderr, "libloc_api_fake.so not found, no latencies\n");
+    }
+
+    // the same copy the gps HAL is linked against
+    void* core = dlopen("libloc_core.so", RTLD_NOW);
+    if (NULL != core) {
+        msgs_processed = (msgs_processed_t*)dlsym(core,
+                                                  "loc_msg_task_processed");
+    }
+    if (NULL == msgs_processed) {
+        fprintf(stderr, "libloc_core.so not found, no msgs/sec\n");
+    }
+
+    const hw_module_t* module;
+    hw_device_t* device;
+    if (hw_get_module(GPS_HARDWARE_MODULE_ID, &module) ||
+        module->methods->open(module, GPS_HARDWARE_MODULE_ID, &device)) {
+        fprintf(stderr, "failed to open the gps HAL\n");
+        return 1;
+    }
+
+    const GpsInterface* gps =
+        ((struct gps_device_t*)device)->get_gps_interface(
+            (struct gps_device_t*)device);
+    if (NULL == gps || gps->init(&callbacks)) {
+        fprintf(stderr, "failed to init the gps HAL\n");
+        return 1;
+    }
+
+    gps->set_position_mode(GPS_POSITION_MODE_STANDALONE,
+                           GPS_POSITION_RECURRENCE_PERIODIC,
+                           interval, 0, 0);
+
+    int64_t start = bench_now_ns();
+    allocs_at_start = allocs;
+    uint32_t msgs_at_start = msgs_processed ? msgs_processed() : 0;
+    gps->start();
+    sleep(duration);
+    gps->stop();
+    int64_t elapsed = bench_now_ns() - start;
+    uint32_t num_allocs = allocs - allocs_at_start;
+    uint32_t num_msgs = msgs_processed ? msgs_processed() - msgs_at_start : 0;
+
+    pthread_mutex_lock(&bench_lock);
+    qsort(latencies, num_fixes, sizeof(latencies[0]), compare_int64);
+    printf("callbacks: fixes: %d (%d unmatched), sv: %u, nmea: %u, "
+           "status: %u\n",
+           num_fixes, num_unmatched, num_sv, num_nmea, num_status);
+    printf("callback latency us: p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+           percentile_us(50), percentile_us(90), percentile_us(99),
+           percentile_us(100));
+    printf("msgs/sec: %.1f\n", num_msgs * 1e9 / elapsed);
+    printf("allocs/fix: %.1f\n", num_fixes + num_unmatched ?
+           (double)num_allocs / (num_fixes + num_unmatched) : 0.0);
+    pthread_mutex_unlock(&bench_lock);
+
+    gps->cleanup();
+    return 0;
+}
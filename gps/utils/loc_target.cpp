@@ -34,8 +34,12 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 #include <hardware/gps.h>
 #include <cutils/properties.h>
+#include <sys/_system_properties.h>
 #include "loc_target.h"
 #include "loc_log.h"
 #include "log_util.h"
@@ -63,6 +67,109 @@
 
 static unsigned int gTarget = (unsigned int)-1;
 
+// shared by is_qca1530() and the watch thread serving it, freed by whichever
+// of the two lets go last
+struct prop_watch {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned int serial;
+    int refs;
+};
+
+static void prop_watch_put(struct prop_watch* watch)
+{
+    int refs;
+
+    pthread_mutex_lock(&watch->lock);
+    refs = --watch->refs;
+    pthread_mutex_unlock(&watch->lock);
+    if (!refs) {
+        pthread_cond_destroy(&watch->cond);
+        pthread_mutex_destroy(&watch->lock);
+        free(watch);
+    }
+}
+
+// publishes property area updates until the waiter lets go; it notices that
+// on the first update after, so it never outlives the detection by more
+// than one property change
+static void* prop_watch_proc(void* arg)
+{
+    struct prop_watch* watch = (struct prop_watch*)arg;
+    unsigned int serial;
+    bool waited;
+
+    pthread_mutex_lock(&watch->lock);
+    serial = watch->serial;
+    pthread_mutex_unlock(&watch->lock);
+
+    do {
+        serial = __system_property_wait_any(serial);
+        pthread_mutex_lock(&watch->lock);
+        watch->serial = serial;
+        waited = watch->refs > 1;
+        pthread_cond_broadcast(&watch->cond);
+        pthread_mutex_unlock(&watch->lock);
+    } while (waited);
+
+    prop_watch_put(watch);
+    return NULL;
+}
+
+static struct prop_watch* prop_watch_start(unsigned int serial)
+{
+    struct prop_watch* watch;
+    pthread_condattr_t cattr;
+    pthread_attr_t attr;
+    pthread_t tid;
+    int err;
+
+    watch = (struct prop_watch*)malloc(sizeof(*watch));
+    if (NULL == watch) {
+        return NULL;
+    }
+    pthread_mutex_init(&watch->lock, NULL);
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&watch->cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+    watch->serial = serial;
+    watch->refs = 2;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    err = pthread_create(&tid, &attr, prop_watch_proc, watch);
+    pthread_attr_destroy(&attr);
+    if (err) {
+        LOC_LOGE("qca1530: property watch not started: %s", strerror(err));
+        watch->refs = 1;
+        prop_watch_put(watch);
+        return NULL;
+    }
+    return watch;
+}
+
+/*!
+ * \brief Waits for the property area to change from serial.
+ *
+ * \retval true - a property changed.
+ * \retval false - deadline passed.
+ */
+static bool prop_watch_wait(struct prop_watch* watch, unsigned int* serial,
+                            const struct timespec* deadline)
+{
+    bool changed;
+
+    pthread_mutex_lock(&watch->lock);
+    while (watch->serial == *serial &&
+           ETIMEDOUT != pthread_cond_timedwait(&watch->cond, &watch->lock,
+                                               deadline));
+    changed = (watch->serial != *serial);
+    *serial = watch->serial;
+    pthread_mutex_unlock(&watch->lock);
+    return changed;
+}
+
 static int read_a_line(const char * file_path, char * line, int line_size)
 {
     FILE *fp;
@@ -92,7 +199,9 @@ static int read_a_line(const char * file_path, char * line, int line_size)
  * based on property value. For 1530 scenario, the value shall be one of the
  * following: "yes", "no", "detect". All other values are treated equally to
  * "no". When the value is "detect" the system waits for SoC detection to
- * finish before returning result.
+ * finish before returning result. It is woken up by property changes, seen
+ * by a watch thread started for the wait, for QCA1530_DETECT_TIMEOUT seconds
+ * at most.
  *
  * \retval true - QCA1530 is available.
  * \retval false - QCA1530 is not available.
@@ -101,12 +210,19 @@ static bool is_qca1530(void)
 {
     static const char qca1530_property_name[] = "persist.qca1530";
     bool res = false;
-    int ret, i;
+    struct prop_watch* watch = NULL;
+    struct timespec deadline;
+    unsigned int serial;
+    int ret;
     char buf[PROPERTY_VALUE_MAX];
 
     memset(buf, 0, sizeof(buf));
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += QCA1530_DETECT_TIMEOUT;
+    // taken before the first read, so an update in between is not missed
+    serial = __system_property_area_serial();
 
-    for (i = 0; i < QCA1530_DETECT_TIMEOUT; ++i)
+    while (1)
     {
         ret = property_get(qca1530_property_name, buf, NULL);
         if (ret < 0)
@@ -132,12 +248,24 @@ static bool is_qca1530(void)
                     sizeof(QCA1530_DETECT_PROGRESS)))
         {
             LOC_LOGV("qca1530: SoC detection is in progress.");
-            sleep(1);
-            continue;
+            if (NULL == watch) {
+                watch = prop_watch_start(serial);
+                if (NULL == watch) {
+                    break;
+                }
+            }
+            if (prop_watch_wait(watch, &serial, &deadline)) {
+                continue;
+            }
+            LOC_LOGE("qca1530: SoC detection timed out");
         }
         break;
     }
 
+    if (NULL != watch) {
+        prop_watch_put(watch);
+    }
+
     LOC_LOGD("qca1530: detected=%s", res ? "true" : "false");
     return res;
 }
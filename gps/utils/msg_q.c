@@ -36,11 +36,21 @@
 #include <stdlib.h>
 #include <pthread.h>
 
+#define MSG_Q_LANES_MAX 4
+
 typedef struct msg_q {
    void* msg_list;                  /* Linked list to store information */
    pthread_cond_t  list_cond;       /* Condition variable for waiting on msg queue */
    pthread_mutex_t list_mutex;      /* Mutex for exclusive access to message queue */
    int unblocked;                   /* Has this message queue been unblocked? */
+   pthread_t receiver;              /* Last thread to receive from the queue */
+   int has_receiver;                /* Is receiver valid? */
+   struct msg_q* parent;            /* Queue this lane is received through */
+   struct msg_q* lanes[MSG_Q_LANES_MAX]; /* Lanes received through this queue */
+   int num_lanes;
+   int weight;                      /* Messages taken in a row on each turn */
+   int credit;                      /* Messages left in the current turn */
+   int turn;                        /* 0 for this queue, n for lanes[n - 1] */
 } msg_q;
 
 /*===========================================================================
@@ -82,6 +92,102 @@ static msq_q_err_type convert_linked_list_err_type(linked_list_err_type linked_l
    }
 }
 
+/*===========================================================================
+FUNCTION    msg_q_owner
+
+DESCRIPTION
+   Returns the queue whose mutex, condition and receiver serve msg_q, that is
+   its parent for a lane and msg_q itself otherwise.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Owning message queue
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static msg_q* msg_q_owner(msg_q* p_msg_q)
+{
+   return p_msg_q->parent ? p_msg_q->parent : p_msg_q;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_empty
+
+DESCRIPTION
+   Checks msg_q and all of its lanes for messages. Called with the mutex of
+   msg_q held.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   1 if there is no message to receive; 0 otherwise
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static int msg_q_empty(msg_q* p_msg_q)
+{
+   int i;
+
+   if( !linked_list_empty(p_msg_q->msg_list) )
+   {
+      return 0;
+   }
+   for( i = 0; i < p_msg_q->num_lanes; i++ )
+   {
+      if( !linked_list_empty(p_msg_q->lanes[i]->msg_list) )
+      {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_next_turn
+
+DESCRIPTION
+   Picks the queue, msg_q or one of its lanes, to receive the next message
+   from. They take turns in a round robin, and each one gives up its turn
+   after weight messages or when it runs empty, so a busy lane cannot hold
+   the others back by more than its weight. Called with the mutex of msg_q
+   held.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Queue to receive from; msg_q itself if there is no message anywhere
+
+SIDE EFFECTS
+   Moves the turn on.
+
+===========================================================================*/
+static msg_q* msg_q_next_turn(msg_q* p_msg_q)
+{
+   int i;
+
+   /* a full round plus one step comes back to a refilled queue */
+   for( i = 0; i <= p_msg_q->num_lanes + 1; i++ )
+   {
+      msg_q* turn = p_msg_q->turn ? p_msg_q->lanes[p_msg_q->turn - 1] : p_msg_q;
+      if( turn->credit > 0 && !linked_list_empty(turn->msg_list) )
+      {
+         turn->credit--;
+         return turn;
+      }
+      turn->credit = turn->weight;
+      p_msg_q->turn = (p_msg_q->turn + 1) % (p_msg_q->num_lanes + 1);
+   }
+   return p_msg_q;
+}
+
 /* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
 
 /*===========================================================================
@@ -130,6 +236,8 @@ msq_q_err_type msg_q_init(void** msg_q_data)
    }
 
    tmp_msg_q->unblocked = 0;
+   tmp_msg_q->weight = 1;
+   tmp_msg_q->credit = 1;
 
    *msg_q_data = tmp_msg_q;
 
@@ -150,6 +258,46 @@ const void* msg_q_init2()
   return q;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_init_lane
+
+  ===========================================================================*/
+const void* msg_q_init_lane(void* parent_data, int weight)
+{
+   if( parent_data == NULL || weight <= 0 )
+   {
+      LOC_LOGE("%s: Invalid parameter!\n", __FUNCTION__);
+      return NULL;
+   }
+
+   msg_q* p_parent = (msg_q*)parent_data;
+   void* q = NULL;
+   if( p_parent->parent != NULL || eMSG_Q_SUCCESS != msg_q_init(&q) )
+   {
+      return NULL;
+   }
+
+   msg_q* p_msg_q = (msg_q*)q;
+   p_msg_q->parent = p_parent;
+   p_msg_q->weight = weight;
+   p_msg_q->credit = weight;
+
+   pthread_mutex_lock(&p_parent->list_mutex);
+   if( p_parent->num_lanes == MSG_Q_LANES_MAX )
+   {
+      pthread_mutex_unlock(&p_parent->list_mutex);
+      LOC_LOGE("%s: No room for another lane!\n", __FUNCTION__);
+      p_msg_q->parent = NULL;
+      msg_q_destroy(&q);
+      return NULL;
+   }
+   p_parent->lanes[p_parent->num_lanes++] = p_msg_q;
+   pthread_mutex_unlock(&p_parent->list_mutex);
+
+   return q;
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_destroy
@@ -164,6 +312,24 @@ msq_q_err_type msg_q_destroy(void** msg_q_data)
    }
 
    msg_q* p_msg_q = (msg_q*)*msg_q_data;
+   msg_q* p_parent = p_msg_q->parent;
+
+   if( p_parent != NULL )
+   {
+      int i;
+
+      pthread_mutex_lock(&p_parent->list_mutex);
+      for( i = 0; i < p_parent->num_lanes; i++ )
+      {
+         if( p_parent->lanes[i] == p_msg_q )
+         {
+            p_parent->lanes[i] = p_parent->lanes[--p_parent->num_lanes];
+            break;
+         }
+      }
+      p_parent->turn = 0;
+      pthread_mutex_unlock(&p_parent->list_mutex);
+   }
 
    linked_list_destroy(&p_msg_q->msg_list);
    pthread_mutex_destroy(&p_msg_q->list_mutex);
@@ -197,23 +363,24 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
    }
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
+   msg_q* p_owner = msg_q_owner(p_msg_q);
 
-   pthread_mutex_lock(&p_msg_q->list_mutex);
+   pthread_mutex_lock(&p_owner->list_mutex);
    LOC_LOGD("%s: Sending message with handle = 0x%08X\n", __FUNCTION__, msg_obj);
 
-   if( p_msg_q->unblocked )
+   if( p_msg_q->unblocked || p_owner->unblocked )
    {
       LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
-      pthread_mutex_unlock(&p_msg_q->list_mutex);
+      pthread_mutex_unlock(&p_owner->list_mutex);
       return eMSG_Q_UNAVAILABLE_RESOURCE;
    }
 
    rv = convert_linked_list_err_type(linked_list_add(p_msg_q->msg_list, msg_obj, dealloc));
 
    /* Show data is in the message queue. */
-   pthread_cond_signal(&p_msg_q->list_cond);
+   pthread_cond_signal(&p_owner->list_cond);
 
-   pthread_mutex_unlock(&p_msg_q->list_mutex);
+   pthread_mutex_unlock(&p_owner->list_mutex);
 
    LOC_LOGD("%s: Finished Sending message with handle = 0x%08X\n", __FUNCTION__, msg_obj);
 
@@ -242,6 +409,12 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
+   if( p_msg_q->parent != NULL )
+   {
+      LOC_LOGE("%s: Lanes are received through their parent!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+
    LOC_LOGD("%s: Waiting on message\n", __FUNCTION__);
 
    pthread_mutex_lock(&p_msg_q->list_mutex);
@@ -253,13 +426,16 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
       return eMSG_Q_UNAVAILABLE_RESOURCE;
    }
 
+   p_msg_q->receiver = pthread_self();
+   p_msg_q->has_receiver = 1;
+
    /* Wait for data in the message queue */
-   while( linked_list_empty(p_msg_q->msg_list) && !p_msg_q->unblocked )
+   while( msg_q_empty(p_msg_q) && !p_msg_q->unblocked )
    {
       pthread_cond_wait(&p_msg_q->list_cond, &p_msg_q->list_mutex);
    }
 
-   rv = convert_linked_list_err_type(linked_list_remove(p_msg_q->msg_list, msg_obj));
+   rv = convert_linked_list_err_type(linked_list_remove(msg_q_next_turn(p_msg_q)->msg_list, msg_obj));
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
@@ -284,14 +460,16 @@ msq_q_err_type msg_q_flush(void* msg_q_data)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
+   msg_q* p_owner = msg_q_owner(p_msg_q);
+
    LOC_LOGD("%s: Flushing Message Queue\n", __FUNCTION__);
 
-   pthread_mutex_lock(&p_msg_q->list_mutex);
+   pthread_mutex_lock(&p_owner->list_mutex);
 
    /* Remove all elements from the list */
    rv = convert_linked_list_err_type(linked_list_flush(p_msg_q->msg_list));
 
-   pthread_mutex_unlock(&p_msg_q->list_mutex);
+   pthread_mutex_unlock(&p_owner->list_mutex);
 
    LOC_LOGD("%s: Message Queue flushed\n", __FUNCTION__);
 
@@ -312,25 +490,48 @@ msq_q_err_type msg_q_unblock(void* msg_q_data)
    }
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
-   pthread_mutex_lock(&p_msg_q->list_mutex);
+   msg_q* p_owner = msg_q_owner(p_msg_q);
+   pthread_mutex_lock(&p_owner->list_mutex);
 
    if( p_msg_q->unblocked )
    {
       LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
-      pthread_mutex_unlock(&p_msg_q->list_mutex);
+      pthread_mutex_unlock(&p_owner->list_mutex);
       return eMSG_Q_UNAVAILABLE_RESOURCE;
    }
 
    LOC_LOGD("%s: Unblocking Message Queue\n", __FUNCTION__);
-   /* Unblocking message queue */
+   /* Unblocking message queue, a lane only stops taking messages */
    p_msg_q->unblocked = 1;
 
    /* Allow all the waiters to wake up */
-   pthread_cond_broadcast(&p_msg_q->list_cond);
+   pthread_cond_broadcast(&p_owner->list_cond);
 
-   pthread_mutex_unlock(&p_msg_q->list_mutex);
+   pthread_mutex_unlock(&p_owner->list_mutex);
 
    LOC_LOGD("%s: Message Queue unblocked\n", __FUNCTION__);
 
    return eMSG_Q_SUCCESS;
 }
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_is_receiver
+
+  ===========================================================================*/
+int msg_q_is_receiver(const void* msg_q_data)
+{
+   int rv;
+   if ( msg_q_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
+      return 0;
+   }
+
+   msg_q* p_owner = msg_q_owner((msg_q*)msg_q_data);
+   pthread_mutex_lock(&p_owner->list_mutex);
+   rv = p_owner->has_receiver && pthread_equal(p_owner->receiver, pthread_self());
+   pthread_mutex_unlock(&p_owner->list_mutex);
+
+   return rv;
+}
@@ -90,6 +90,31 @@ SIDE EFFECTS
 ===========================================================================*/
 const void* msg_q_init2();
 
+/*===========================================================================
+FUNCTION    msg_q_init_lane
+
+DESCRIPTION
+   Initializes a lane of a message queue: a queue of its own, sent to as
+   usual but received from through its parent. The receiver of the parent
+   takes messages from the parent and its lanes in turn, up to weight of
+   them in a row from each, so that one busy lane does not hold back the
+   others. Order is kept within a queue, not across them.
+
+   parent_data: Message queue to receive the lane through; not a lane.
+   weight:      Messages taken from the lane on each of its turns.
+
+DEPENDENCIES
+   Lanes must be destroyed before their parent.
+
+RETURN VALUE
+   opaque handle to the lane created; NULL if create fails
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+const void* msg_q_init_lane(void* parent_data, int weight);
+
 /*===========================================================================
 FUNCTION    msg_q_destroy
 
@@ -140,7 +165,8 @@ FUNCTION    msg_q_rcv
 
 DESCRIPTION
    Retrieves data from the message queue. msg_obj is the oldest message received
-   and pointer is simply removed from message queue.
+   and pointer is simply removed from message queue. With lanes, it is the
+   oldest message of the queue or lane whose turn it is.
 
    msg_q_data: Message Queue to copy data from into msgp.
    msg_obj:    Pointer to space to copy msg_q contents to.
@@ -184,7 +210,8 @@ DESCRIPTION
    This function will stop use of the message queue. All waiters will wake up
    and likely receive nothing from the queue resulting in a negative return
    value. The message queue can no longer be used until it is destroyed
-   and initialized again after calling this function.
+   and initialized again after calling this function. Unblocking a lane only
+   makes sending to it fail; its parent goes on.
 
    msg_q_data: Message queue to unblock.
 
@@ -200,6 +227,27 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_unblock(void* msg_q_data);
 
+/*===========================================================================
+FUNCTION    msg_q_is_receiver
+
+DESCRIPTION
+   Tells if the calling thread is the one receiving from the message queue,
+   i.e. if it is processing a message taken from it.
+
+   msg_q_data: Message queue to check.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   1 if the caller last received from the queue; 0 otherwise.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+int msg_q_is_receiver(const void* msg_q_data);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -15,11 +15,17 @@
  */
 
 #include <cutils/log.h>
+#include <cutils/properties.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
 
 #include <hardware/lights.h>
 
@@ -30,6 +36,9 @@
 #define LED_LIGHT_OFF 0
 #define LED_LIGHT_ON 255
 
+/* "%x0000 %d %d 1 1" and "%d\n" both fit comfortably */
+#define NODE_BUF_SIZE 64
+
 static pthread_once_t g_init = PTHREAD_ONCE_INIT;
 static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
 static struct light_state_t g_attention;
@@ -40,6 +49,51 @@ char const*const LCD_FILE
 char const*const RGB_CONTROL_FILE
         = "/sys/class/leds/rgb/control";
 
+/*
+ * A sysfs node kept open for the lifetime of the HAL, together with the
+ * last value successfully written to it so that repeated writes of the
+ * same state can be skipped. Accessed under g_lock only.
+ */
+struct sysfs_node {
+    char const *path;
+    int fd;
+    int warned;
+    int last_len;
+    char last[NODE_BUF_SIZE];
+};
+
+static struct sysfs_node g_lcd = { .fd = -1, .last_len = -1 };
+static struct sysfs_node g_rgb = { .fd = -1, .last_len = -1 };
+
+/*
+ * Backlight ramp engine. A request with a non-zero duration starts (or
+ * retargets) a ramp from the current level, and a single worker thread
+ * driven by a timerfd steps LCD_FILE until the target is reached. Steps
+ * are interpolated in gamma 2 space so the change looks linear to the eye.
+ *
+ * The duration is taken from flashOnMS when flashMode is LIGHT_FLASH_TIMED,
+ * otherwise auto-brightness (BRIGHTNESS_MODE_SENSOR) requests use
+ * BACKLIGHT_RAMP_PROP and everything else is applied immediately.
+ */
+#define BACKLIGHT_RAMP_PROP "ro.lights.backlight_ramp_ms"
+#define BACKLIGHT_RAMP_MAX_MS 5000
+#define BACKLIGHT_RAMP_STEP_NS (16 * 1000000LL)
+
+struct backlight_ramp {
+    int timer_fd;
+    int default_ms;
+    int active;
+    /* last level written to LCD_FILE, -1 if unknown */
+    int level;
+    int start;
+    int target;
+    int64_t start_ns;
+    int64_t duration_ns;
+};
+
+static pthread_once_t g_ramp_init = PTHREAD_ONCE_INIT;
+static struct backlight_ramp g_ramp = { .timer_fd = -1, .level = -1 };
+
 /**
  * device methods
  */
@@ -48,50 +102,91 @@ void init_globals(void)
 {
     // init the mutex
     pthread_mutex_init(&g_lock, NULL);
+
+    g_lcd.path = LCD_FILE;
+    g_rgb.path = RGB_CONTROL_FILE;
+
+    g_ramp.default_ms = property_get_int32(BACKLIGHT_RAMP_PROP, 0);
 }
 
 static int
-write_int(char const* path, int value)
+node_open(struct sysfs_node *node)
 {
-    int fd;
-    static int already_warned = 0;
-
-    fd = open(path, O_RDWR);
-    if (fd >= 0) {
-        char buffer[20];
-        int bytes = sprintf(buffer, "%d\n", value);
-        int amt = write(fd, buffer, bytes);
-        close(fd);
-        return amt == -1 ? -errno : 0;
-    } else {
-        if (already_warned == 0) {
-            ALOGE("write_int failed to open %s\n", path);
-            already_warned = 1;
+    if (node->fd >= 0)
+        return 0;
+
+    node->fd = open(node->path, O_RDWR | O_CLOEXEC);
+    if (node->fd < 0) {
+        int err = -errno;
+        if (!node->warned) {
+            ALOGE("failed to open %s\n", node->path);
+            node->warned = 1;
         }
-        return -errno;
+        return err;
     }
+
+    return 0;
+}
+
+static void
+node_close(struct sysfs_node *node)
+{
+    if (node->fd >= 0) {
+        close(node->fd);
+        node->fd = -1;
+    }
+    node->last_len = -1;
 }
 
 static int
-write_str(char const* path, char *value)
+node_write(struct sysfs_node *node, char const *buf, int len)
 {
-    int fd;
-    static int already_warned = 0;
-
-    fd = open(path, O_RDWR);
-    if (fd >= 0) {
-        char buffer[PAGE_SIZE];
-        int bytes = sprintf(buffer, "%s\n", value);
-        int amt = write(fd, buffer, bytes);
-        close(fd);
-        return amt == -1 ? -errno : 0;
-    } else {
-        if (already_warned == 0) {
-            ALOGE("write_str failed to open %s\n", path);
-            already_warned = 1;
-        }
-        return -errno;
+    int retried = 0;
+    int err;
+
+    if (len == node->last_len && !memcmp(buf, node->last, len))
+        return 0;
+
+    for (;;) {
+        err = node_open(node);
+        if (err)
+            return err;
+
+        if (pwrite(node->fd, buf, len, 0) >= 0)
+            break;
+
+        /* the node may have gone stale, reopen it once before giving up */
+        err = -errno;
+        node_close(node);
+        if (retried++)
+            return err;
     }
+
+    memcpy(node->last, buf, len);
+    node->last_len = len;
+
+    return 0;
+}
+
+static int
+write_int(struct sysfs_node *node, int value)
+{
+    char buffer[NODE_BUF_SIZE];
+    int bytes = snprintf(buffer, sizeof(buffer), "%d\n", value);
+
+    return node_write(node, buffer, bytes);
+}
+
+static int
+write_str(struct sysfs_node *node, char const *value)
+{
+    char buffer[NODE_BUF_SIZE];
+    int bytes = snprintf(buffer, sizeof(buffer), "%s\n", value);
+
+    if (bytes >= (int)sizeof(buffer))
+        return -EINVAL;
+
+    return node_write(node, buffer, bytes);
 }
 
 static int
@@ -108,14 +203,158 @@ rgb_to_brightness(struct light_state_t const* state)
             + (150*((color>>8)&0x00ff)) + (29*(color&0x00ff))) >> 8;
 }
 
+static int64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void
+ramp_arm_timer(int64_t interval_ns)
+{
+    struct itimerspec spec;
+
+    memset(&spec, 0, sizeof(spec));
+    if (interval_ns) {
+        spec.it_interval.tv_sec = interval_ns / 1000000000LL;
+        spec.it_interval.tv_nsec = interval_ns % 1000000000LL;
+        spec.it_value = spec.it_interval;
+    }
+
+    timerfd_settime(g_ramp.timer_fd, 0, &spec, NULL);
+}
+
+/* level of the running ramp at the given time, in gamma 2 space */
+static int
+ramp_level_locked(int64_t now)
+{
+    float a, b, p, v;
+
+    if (now - g_ramp.start_ns >= g_ramp.duration_ns)
+        return g_ramp.target;
+
+    p = (float)(now - g_ramp.start_ns) / g_ramp.duration_ns;
+    a = sqrtf(g_ramp.start);
+    b = sqrtf(g_ramp.target);
+    v = a + (b - a) * p;
+
+    return (int)(v * v + 0.5f);
+}
+
+static int
+write_backlight_locked(int level)
+{
+    int err = write_int(&g_lcd, level);
+
+    g_ramp.level = err ? -1 : level;
+    return err;
+}
+
+static void *
+ramp_thread(__attribute__((unused)) void *arg)
+{
+    uint64_t expirations;
+
+    for (;;) {
+        if (read(g_ramp.timer_fd, &expirations, sizeof(expirations)) < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            ALOGE("backlight ramp timer read failed: %d\n", errno);
+            break;
+        }
+
+        pthread_mutex_lock(&g_lock);
+        if (g_ramp.active) {
+            int level = ramp_level_locked(now_ns());
+
+            write_backlight_locked(level);
+            if (level == g_ramp.target) {
+                g_ramp.active = 0;
+                ramp_arm_timer(0);
+            }
+        }
+        pthread_mutex_unlock(&g_lock);
+    }
+
+    return NULL;
+}
+
+static void
+init_ramp(void)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    g_ramp.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (g_ramp.timer_fd < 0) {
+        ALOGE("failed to create backlight ramp timer: %d\n", errno);
+        return;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, ramp_thread, NULL)) {
+        ALOGE("failed to start backlight ramp thread\n");
+        close(g_ramp.timer_fd);
+        g_ramp.timer_fd = -1;
+    }
+    pthread_attr_destroy(&attr);
+}
+
+static int
+ramp_duration_ms(struct light_state_t const* state)
+{
+    int ms;
+
+    if (state->flashMode == LIGHT_FLASH_TIMED)
+        ms = state->flashOnMS;
+    else if (state->brightnessMode == BRIGHTNESS_MODE_SENSOR)
+        ms = g_ramp.default_ms;
+    else
+        ms = 0;
+
+    if (ms < 0)
+        ms = 0;
+    if (ms > BACKLIGHT_RAMP_MAX_MS)
+        ms = BACKLIGHT_RAMP_MAX_MS;
+
+    return ms;
+}
+
 static int
 set_light_backlight(__attribute__((unused)) struct light_device_t* dev,
         struct light_state_t const* state)
 {
     int err = 0;
     int brightness = rgb_to_brightness(state);
+    int duration_ms = ramp_duration_ms(state);
+
+    if (duration_ms)
+        pthread_once(&g_ramp_init, init_ramp);
+
     pthread_mutex_lock(&g_lock);
-    err = write_int(LCD_FILE, brightness);
+    if (!duration_ms || g_ramp.timer_fd < 0 || g_ramp.level < 0 ||
+            g_ramp.level == brightness) {
+        /* jump straight there, cancelling any ramp in flight */
+        if (g_ramp.active) {
+            g_ramp.active = 0;
+            ramp_arm_timer(0);
+        }
+        err = write_backlight_locked(brightness);
+    } else {
+        /* (re)target from wherever the panel is now */
+        g_ramp.start = g_ramp.level;
+        g_ramp.target = brightness;
+        g_ramp.start_ns = now_ns();
+        g_ramp.duration_ns = duration_ms * 1000000LL;
+        if (!g_ramp.active) {
+            g_ramp.active = 1;
+            ramp_arm_timer(BACKLIGHT_RAMP_STEP_NS);
+        }
+    }
     pthread_mutex_unlock(&g_lock);
     return err;
 }
@@ -125,7 +364,7 @@ set_light_locked(struct light_state_t const* state)
 {
     int onMS, offMS;
     int brightness_level;
-    char blink_pattern[PAGE_SIZE];
+    char blink_pattern[NODE_BUF_SIZE];
 
     switch (state->flashMode) {
         case LIGHT_FLASH_TIMED:
@@ -151,9 +390,10 @@ set_light_locked(struct light_state_t const* state)
      * is actually the brightness level (0 <-> 255).
      * Ramp up/down are hard-coded in the kernel driver.
      */
-    sprintf(blink_pattern, "%x0000 %d %d 1 1", brightness_level, onMS, offMS);
+    snprintf(blink_pattern, sizeof(blink_pattern), "%x0000 %d %d 1 1",
+            brightness_level, onMS, offMS);
 
-    return write_str(RGB_CONTROL_FILE, blink_pattern);
+    return write_str(&g_rgb, blink_pattern);
 }
 
 static int
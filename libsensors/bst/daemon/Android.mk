@@ -12,11 +12,15 @@ LOCAL_SRC_FILES := \
     src/misc.c \
     src/trace.c \
     src/sensor_cfg.c \
+    src/cfg_snapshot.c \
+    src/calib_store.c \
     src/event_handler.c \
     src/lib/util_misc.c \
     src/lib/util_time.c \
     src/lib/util_sysfs.c \
     src/lib/util_input_dev.c \
+    src/lib/util_bench.c \
+    src/lib/util_ring.c \
     src/channel_cntl.c \
     src/channel_a.c \
     src/channel_g.c \
@@ -35,7 +39,10 @@ LOCAL_SRC_FILES := \
     src/channels.c \
     src/sensor_provider.c \
     src/sensor_fusion.c \
-    src/hw/hw_cntl.c
+    src/hw/hw_cntl.c \
+    ../../common/axis_conv.c \
+    ../../common/input_registry.c \
+    ../../common/util_hist.c
 
 LOCAL_C_INCLUDES += $(LOCAL_PATH) \
                     $(LOCAL_PATH)/inc \
@@ -43,6 +50,7 @@ LOCAL_C_INCLUDES += $(LOCAL_PATH) \
                     $(LOCAL_PATH)/algo/inc \
                     $(LOCAL_PATH)/src/algo \
                     $(LOCAL_PATH)/src/hw \
+                    $(LOCAL_PATH)/../../common \
 
 ifeq (arm,$(TARGET_ARCH))
 LOCAL_LDFLAGS += $(LOCAL_PATH)/algo/lib/bosch_lib32/libalgobsx.a
@@ -277,6 +277,12 @@ int algo_init(void);
 
 int algo_enable_product(struct algo_product *ap, int enable);
 
+/*
+ * while held, product and interval changes are only recorded; the work
+ * mode transit and data rate arbitration run once on release
+ */
+void algo_hold_update(int hold);
+
 int algo_set_opmode(int32_t sensor_type, int32_t opmode);
 
 BS_U8 algo_proc_data_a(BS_S32 ts);
@@ -353,6 +359,13 @@ void algo_on_interval_changed(struct algo_product *ap, int *interval);
 
 BS_S32 algo_proc_data(uint32_t ts);
 
+/* bitmap of the on-change products updated since the last call */
+uint32_t algo_get_changed_products();
+
+BS_S32 algo_sample_data(uint32_t ts, void *frame);
+
+void algo_fuse_data(void *frame);
+
 void algo_adapter_init();
 
 void algo_mod_init();
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CALIB_STORE_H
+#define __CALIB_STORE_H
+
+/*
+ * Calibration profiles kept in memory and persisted by a background
+ * thread to an append-only journal of fixed size records, each with a
+ * sequence number and a CRC32. A torn record at the end of the journal
+ * is simply skipped, so a power loss costs at most the last update.
+ * The journal is compacted to the latest record of every profile when
+ * it grows, by writing it aside and renaming it into place.
+ */
+
+#define CALIB_STORE_FILE (PATH_DIR_SENSOR_STORAGE "/calib_journal")
+
+#define CALIB_STORE_DATA_SIZE 64
+
+enum {
+    CALIB_STORE_A,
+    CALIB_STORE_M,
+    CALIB_STORE_G,
+    CALIB_STORE_MAX
+};
+
+/* restore the latest valid profiles and start the writer */
+int calib_store_init(void);
+
+/* copy a profile to buf, returns its length or -ENOENT */
+int calib_store_get(int id, void *buf, int size);
+
+/* update a profile, it is written out shortly after without blocking */
+int calib_store_put(int id, const void *buf, int len);
+
+/* forget all the profiles, in memory and on storage */
+void calib_store_clear(void);
+
+/* write the config snapshot from the writer thread, without blocking */
+void calib_store_sync_snapshot(void);
+
+#endif
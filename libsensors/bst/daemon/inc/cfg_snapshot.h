@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CFG_SNAPSHOT_H
+#define __CFG_SNAPSHOT_H
+
+#include <stdint.h>
+
+/*
+ * Binary snapshot of the resolved configuration, so that a cold start
+ * does not parse the text config files again.
+ *
+ * Each item keeps the mtime and size of the file it was resolved from
+ * and is only used while that file is unchanged; a stale or missing item
+ * is resolved the usual way and recorded through cfg_snapshot_put().
+ * The input device mapping is kept too and seeds the input registry.
+ */
+
+#define CFG_SNAPSHOT_FILE (PATH_DIR_SENSOR_STORAGE "/cfg_snapshot")
+
+/* largest item, keep it in sync with the types below */
+#define CFG_SNAPSHOT_ITEM_SIZE 64
+
+enum cfg_snapshot_item {
+    /* int32_t[3]: g_place_a, g_place_m, g_place_g */
+    CFG_SNAPSHOT_AXIS,
+    /* struct cfg_algo_cust */
+    CFG_SNAPSHOT_ALGO_CUST,
+    /* float[9] */
+    CFG_SNAPSHOT_SOFTIRON,
+    /* calibprofile_crc_t as stored in the profile files */
+    CFG_SNAPSHOT_CALIB_A,
+    CFG_SNAPSHOT_CALIB_M,
+    CFG_SNAPSHOT_CALIB_G,
+    CFG_SNAPSHOT_ITEM_MAX
+};
+
+struct cfg_algo_cust {
+    int32_t param[6];
+    float noise[4];
+    float acc_filt[2];
+};
+
+/* map the snapshot of the last run, before any config is read */
+void cfg_snapshot_load(void);
+
+/*
+ * copy a still valid item to buf, returns its length, 0 when its source
+ * yielded nothing last time, or -ENOENT when it has to be resolved
+ */
+int cfg_snapshot_get(int item, void *buf, int size);
+
+/* record how an item was resolved, len 0 if its source yielded nothing */
+void cfg_snapshot_put(int item, const void *buf, int len);
+
+/* write the snapshot if anything was resolved the slow way */
+void cfg_snapshot_commit(void);
+
+#endif
@@ -136,6 +136,16 @@ struct channel_cfg {
      */
     uint16_t bypass_proc : 1;
 
+    /* kept running at its lowest rate while the display is off,
+     * e.g.: step counter, significant motion
+     */
+    uint16_t wake_up : 1;
+
+    /* data is only fetched when its provider reports a change,
+     * see get_changed() of struct sensor_provider
+     */
+    uint16_t on_change : 1;
+
     /* NOTE: limitations */
     uint16_t interval_min;
     /* NOTE: limitations */
@@ -162,10 +172,17 @@ struct channel {
     int32_t data_status : 4;
     /* NOTE: limitations */
     volatile int16_t interval;
+    /* interval to restore when the display is back on, 0 if none */
+    int16_t interval_awake;
 
     /* NOTE: limitations */
     uint32_t ts_last_ev;
 
+    /* boot time of the last sample delivered, 0 after an enable */
+    int64_t ts_last_report;
+    /* deviation of the delivered sample intervals from the requested */
+    struct util_hist stat_jitter;
+
     struct sensor_provider *sp;
     void *private_data;
     struct list_node client;
@@ -342,4 +359,11 @@ int channel_get_num();
 
 struct channel *channel_get_ch(int handle);
 
+struct ctrl_entry;
+struct ctrl_result;
+
+/* apply a control batch as one reconfiguration, one result per entry */
+int channel_on_batch_received(const struct ctrl_entry *entries, int num,
+                              struct ctrl_result *results);
+
 #endif
\ No newline at end of file
@@ -95,6 +95,7 @@
 #include "configure_hw.h"
 #include "sensor_hw.h"
 #include "hw_def.h"
+#include "axis_conv.h"
 
 #define DELAY_TIME_UI_PROXIMITY (60000) /* max delay response time of user interaction in ms */
 
@@ -107,7 +108,12 @@
 
 int hw_cntl_init();
 
-void hw_remap_sensor_data(sensor_data_ival_t *data, axis_remap_t *remap);
+/* precompute the conversion matrix of a remap table entry */
+void hw_remap_to_conv(const axis_remap_t *remap, struct axis_conv *conv);
+
+/* remap a block of n samples in place */
+void hw_remap_sensor_data(sensor_data_ival_t *data, int n,
+                          const struct axis_conv *conv);
 
 struct sensor_hw *hw_get_hw_by_id(int hw_id);
 
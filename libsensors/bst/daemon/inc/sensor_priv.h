@@ -115,6 +115,7 @@
 #define SENSOR_CFG_FILE_ALGO   "/system/etc/sensor/cfg_algo"
 #define SENSOR_CFG_FILE_SOFTIRON_MATRIX ("/system/etc/sensor/sic_matrix")
 #define SENSOR_CFG_FILE_PATH             "/system/etc/sensor/"
+#define ALGO_SOFTIRON_MATRIX           "softiron_matrix.txt"
 
 
 #define SENSOR_CFG_FILE_ALGO_GEST_FLIP   "/system/etc/sensor/cfg_algo_gest_flip"
@@ -97,6 +97,7 @@
 #include <fcntl.h>
 #include <signal.h>
 #include <pthread.h>
+#include <semaphore.h>
 
 #include <errno.h>
 #include <stdlib.h>
@@ -107,6 +108,7 @@
 #include "options.h"
 
 #include "util_misc.h"
+#include "util_ring.h"
 
 struct run_entity {
     pthread_t ptid;
@@ -129,6 +131,44 @@ struct run_entity {
     pthread_cond_t cond;
 
     void *(*func)(void *);
+
+    /* actual minus scheduled wake up time */
+    struct util_hist stat_wakeup;
+    /* time spent per cycle */
+    struct util_hist stat_proc;
+    /* cycles which took longer than the interval */
+    uint32_t overruns;
+};
+
+
+/* second stage of a pipelined provider, see re_fuse_proc() */
+struct fuse_entity {
+    pthread_t ptid;
+    int32_t tid;
+
+    volatile uint32_t started : 1;
+
+    /* frames sampled by the run entity, waiting to be fused */
+    struct spsc_ring ring;
+    sem_t frames;
+    /* frames sampled while the ring was full */
+    uint32_t dropped;
+
+    /* time spent per frame */
+    struct util_hist stat_proc;
+};
+
+
+/* scheduling of the provider threads, see sp_load_sched() */
+struct sp_sched {
+    /* SCHED_FIFO priority of the run entity, 0 for SCHED_OTHER */
+    int32_t prio;
+    /* the same for the fuse entity */
+    int32_t prio_fuse;
+    /* bitmap of the cpus both may run on, 0 for any */
+    uint32_t cpus;
+    /* timer slack in us, 0 to keep the default */
+    int32_t slack;
 };
 
 
@@ -149,6 +189,9 @@ struct sensor_provider {
     void *private_data;
     pthread_mutex_t lock_ref;
     struct run_entity re;
+    struct fuse_entity fe;
+    struct sp_sched sched;
+    uint32_t held : 1;
 
     /* return value of 0 means success, otherwise failure */
     /* mandatory */
@@ -169,6 +212,17 @@ struct sensor_provider {
      */
     void (*proc_data)(uint32_t);
 
+    /* optional: split proc_data() into two stages, connected by a ring
+     * of frame_size bytes frames. sample_data() reads the h/w on the run
+     * entity thread at the scheduling interval and returns 0 when the
+     * frame is to be fused, fuse_data() runs the algo on the fuse entity
+     * thread, which also reports the channel data. A slow algo step thus
+     * no longer delays the next sampling deadline.
+     */
+    int (*sample_data)(uint32_t, void *);
+    void (*fuse_data)(void *);
+    uint32_t frame_size;
+
     /* optional: */
     int32_t (*get_hint_proc_interval)();
 
@@ -181,6 +235,14 @@ struct sensor_provider {
      * the provider will be notified */
     int (*on_hw_dep_checked)(const hw_dep_set_t *);
 
+    /* optional: between hold_update(1) and the next sp_reconfigure(),
+     * channel and interval changes may be applied all at once */
+    void (*hold_update)(int);
+
+    /* optional: bitmap of the types of the on_change channels with new
+     * data, cleared by the call; called on the thread processing the data */
+    uint32_t (*get_changed)(void);
+
     /* optional: */
     void (*exit)(void *);
 };
@@ -200,8 +262,26 @@ void sp_recalc_interval_re(struct sensor_provider *sp);
 
 void sp_enable_ch(struct sensor_provider *sp, struct channel *ch, int enable);
 
-void *re_proc(void *pparam);
+/*
+ * sp_enable_ch() in steps, so that a batch of channels is switched with
+ * a single h/w dependency check and interval recalculation per provider:
+ * optionally sp_hold_update(), sp_enable_ch_begin() for each channel,
+ * sp_reconfigure() for each provider involved, then sp_enable_ch_end()
+ * for each channel
+ */
+void sp_enable_ch_begin(struct sensor_provider *sp, struct channel *ch,
+                        int enable);
+
+/* defer the work of a provider up to the next sp_reconfigure() */
+void sp_hold_update(struct sensor_provider *sp);
+
+void sp_reconfigure(struct sensor_provider *sp);
+
+void sp_enable_ch_end(struct sensor_provider *sp, struct channel *ch,
+                      int enable);
 
 void *re_proc(void *pparam);
 
+void *re_fuse_proc(void *pparam);
+
 #endif
\ No newline at end of file
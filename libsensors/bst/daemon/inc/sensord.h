@@ -100,6 +100,7 @@
 #include "util_time.h"
 #include "util_sysfs.h"
 #include "util_input_dev.h"
+#include "util_bench.h"
 #include "trace.h"
 #include "bs_log.h"
 
@@ -111,6 +112,8 @@
 #include "sensor_data_type.h"
 #include "sensor_def.h"
 #include "sensor_cfg.h"
+#include "cfg_snapshot.h"
+#include "calib_store.h"
 
 #include "algo.h"
 #include "algo_adapter.h"
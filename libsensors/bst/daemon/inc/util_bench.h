@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_BENCH_H
+#define __UTIL_BENCH_H
+
+#include <stdint.h>
+
+/*
+ * Pipeline benchmark, built with debug_pipeline_bench = true.
+ *
+ * Any h/w with a trace at BENCH_REPLAY_DIR/<hw name>.ev (raw struct
+ * input_event records, i.e. what "cat /dev/input/eventN" produces) is
+ * replaced by a stand-in that plays the trace back in a loop at the
+ * recorded pace, scaled by the sensord.bench.speed percentage. The real
+ * driver is never touched, so the daemon runs without sensor hardware.
+ *
+ * Every BENCH_REPORT_PERIOD_S the per stage latency percentiles, the
+ * throughput, the CPU time and the provider wakeups per second are logged.
+ */
+
+#define BENCH_REPLAY_DIR (PATH_DIR_SENSOR_STORAGE "/replay")
+#define BENCH_REPORT_PERIOD_S 10
+
+enum {
+    /* replayed sample produced -> read by the h/w layer */
+    BENCH_STAGE_SAMPLE,
+    /* proc_data() of a sensor provider, i.e. the fusion algo */
+    BENCH_STAGE_PROC,
+    /* channel get_data() calls plus the write to the data fifo */
+    BENCH_STAGE_REPORT,
+    BENCH_STAGE_MAX
+};
+
+struct sensor_hw;
+
+void bench_init(void);
+
+uint64_t bench_now_ns(void);
+
+void bench_record(int stage, uint64_t ns);
+
+void bench_wakeup(void);
+
+/* returns 0 when hw is now fed from a trace and must not be initialized */
+int bench_replay_attach(struct sensor_hw *hw);
+
+#endif
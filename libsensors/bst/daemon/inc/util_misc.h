@@ -87,6 +87,7 @@
 #ifndef __UTIL_MISC_H
 #define __UTIL_MISC_H
 
+#include "util_hist.h"
 
 #define ABS(x) ((x) > 0 ? (x) : -(x))
 
@@ -176,4 +177,10 @@ int32_t get_nearest_divisible_int(uint32_t a, uint32_t b);
 /* get number of 1s (set bits) in a u32 integer */
 int get_num_set_bits_u32(uint32_t n);
 
+/* CRC-32 of len bytes at buf, continuing from crc (0 to start) */
+uint32_t util_crc32(uint32_t crc, const void *buf, size_t len);
+
+/* log the summary of a histogram */
+void util_hist_dump(const char *name, const struct util_hist *hist);
+
 #endif
\ No newline at end of file
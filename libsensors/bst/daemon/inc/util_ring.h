@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_RING_H
+#define __UTIL_RING_H
+
+#include <stdint.h>
+
+/*
+ * Lock-free ring of fixed size slots for exactly one producer thread and
+ * one consumer thread. Slots are filled and drained in place:
+ *
+ *     slot = ring_produce_slot(r);        slot = ring_consume_slot(r);
+ *     ... fill slot ...                   ... use slot ...
+ *     ring_produce_commit(r);             ring_consume_commit(r);
+ */
+struct spsc_ring {
+    uint8_t *buf;
+    uint32_t slot_size;
+    uint32_t mask;
+    /* only written by the producer */
+    uint32_t head;
+    /* only written by the consumer */
+    uint32_t tail;
+};
+
+/* slots must be a power of 2 */
+int ring_init(struct spsc_ring *r, uint32_t slots, uint32_t slot_size);
+
+void ring_destroy(struct spsc_ring *r);
+
+/* NULL when the ring is full */
+void *ring_produce_slot(struct spsc_ring *r);
+
+void ring_produce_commit(struct spsc_ring *r);
+
+/* NULL when the ring is empty */
+void *ring_consume_slot(struct spsc_ring *r);
+
+void ring_consume_commit(struct spsc_ring *r);
+
+#endif
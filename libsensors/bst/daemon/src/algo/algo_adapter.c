@@ -87,6 +87,7 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
 
 #define LOG_TAG_MODULE "<algo_adapter_bst>"
 
@@ -125,6 +126,15 @@ static BS_U16 g_tab_hz[ALGO_NUM_DR] = {};
 /* record the count of sensors which require hw gyro sensor present */
 static uint32_t g_active_gyro_aps_cnt = 0;
 static uint32_t g_active_aps = 0;
+/* on-change products with new output since the last report */
+static uint32_t g_changed_aps = 0;
+#if __HAL_VER__ >= __SENSORS_DEVICE_API_VERSION_1_0__
+static uint64_t g_steps = 0;
+static uint8_t g_step_status = 0;
+/* step products enabled since the fusion thread last looked, which
+ * alone owns g_steps and g_step_status */
+static uint32_t g_step_reset = 0;
+#endif
 static hw_dep_set_t g_active_hws = 0;
 static hw_dep_set_t g_hws_dep = 0;
 #define HW_IS_ACTIVE(hws, id) (hws & (1 << SENSOR_HW_TYPE_ ## id))
@@ -1031,6 +1041,10 @@ static int algo_hz2data_rate(int hz) {
 }
 
 
+/* set while a batch of channel changes is applied, see algo_hold_update() */
+static int g_update_held;
+static int g_update_pending;
+
 int algo_enable_product(struct algo_product *ap, int enable) {
     int err = 0;
 
@@ -1057,6 +1071,18 @@ int algo_enable_product(struct algo_product *ap, int enable) {
     PDEBUG("g_active_gyro_aps_cnt = %d", g_active_gyro_aps_cnt);
     enable = !!enable;
     g_active_aps = SET_VALUE_BITS(g_active_aps, enable, ap->type, 1);
+#if __HAL_VER__ >= __SENSORS_DEVICE_API_VERSION_1_0__
+    /* make the first step after enabling report the current count */
+    if (enable && ((SENSOR_TYPE_STC == ap->type) ||
+                (SENSOR_TYPE_STD == ap->type))) {
+        __atomic_or_fetch(&g_step_reset, 1 << ap->type, __ATOMIC_RELEASE);
+    }
+#endif
+    if (g_update_held) {
+        g_update_pending = 1;
+        return err;
+    }
+
     algo_mode_transit();
 
     fusion_arbitrate_dr();
@@ -1064,6 +1090,21 @@ int algo_enable_product(struct algo_product *ap, int enable) {
     return err;
 }
 
+
+void algo_hold_update(int hold) {
+    g_update_held = hold;
+    if (hold || !g_update_pending) {
+        return;
+    }
+
+    /* the h/w bandwidth follows in algo_on_hw_dep_checked() */
+    g_update_pending = 0;
+    algo_mode_transit();
+
+    fusion_arbitrate_dr();
+    algo_resolve_internal_state();
+}
+
 int algo_update_sample_rate(void) {
     int ret = 0;
 
@@ -1112,6 +1153,11 @@ void algo_on_interval_changed(struct algo_product *ap, int *itvl) {
     ap->dr_m = dr;
     ap->dr_g = dr;
 
+    if (g_update_held) {
+        g_update_pending = 1;
+        return;
+    }
+
     fusion_arbitrate_dr();
     algo_resolve_internal_state();
 
@@ -1155,9 +1201,34 @@ int algo_get_hint_interval() {
     return ret;
 }
 
+static int algo_calib_snapshot_item(char magic) {
+    switch (magic) {
+    case SENSOR_MAGIC_A:
+        return CFG_SNAPSHOT_CALIB_A;
+    case SENSOR_MAGIC_M:
+        return CFG_SNAPSHOT_CALIB_M;
+    default:
+        return CFG_SNAPSHOT_CALIB_G;
+    }
+}
+
+static int algo_calib_store_id(char magic) {
+    switch (magic) {
+    case SENSOR_MAGIC_A:
+        return CALIB_STORE_A;
+    case SENSOR_MAGIC_M:
+        return CALIB_STORE_M;
+    case SENSOR_MAGIC_G:
+        return CALIB_STORE_G;
+    default:
+        return -1;
+    }
+}
+
 static int algo_read_calib_profile(char magic, void *profile) {
     int err = 0;
     char *filename;
+    int item;
 
     switch (magic) {
     case SENSOR_MAGIC_A:
@@ -1174,9 +1245,25 @@ static int algo_read_calib_profile(char magic, void *profile) {
         return -1;
     }
 
+    err = calib_store_get(algo_calib_store_id(magic), profile,
+                          sizeof(calibprofile_crc_t));
+    if (err > 0) {
+        return err;
+    }
+
+    /* nothing in the store yet, fall back to the file of older versions */
+    item = algo_calib_snapshot_item(magic);
+    err = cfg_snapshot_get(item, profile, sizeof(calibprofile_crc_t));
+    if (err > 0) {
+        return err;
+    } else if (0 == err) {
+        /* there was no profile when the snapshot was taken */
+        return -1;
+    }
 
 //	err = util_fs_read_file(filename, profile, sizeof(ts_calibprofile));
     err = util_fs_read_file(filename, profile, sizeof(calibprofile_crc_t));
+    cfg_snapshot_put(item, profile, err > 0 ? err : 0);
     return err;
 }
 
@@ -1295,6 +1382,9 @@ void algo_save_calib_profile(char magic) {
     BSX_U8 *profile_pu8;
     int i;
 
+    /* no stale padding, the store skips unchanged profiles */
+    memset(&profile, 0, sizeof(profile));
+
     switch (magic) {
 
     case SENSOR_MAGIC_A:
@@ -1326,9 +1416,11 @@ void algo_save_calib_profile(char magic) {
         profile.crc -= profile_pu8[i];
     }
 
-    ret = util_fs_write_file(filename, &profile, sizeof(calibprofile_crc_t));
-    if (ret == -1) {
-        PERR("save caliration file failed:%s\n", filename);
+    /* written out by the calib store thread, never blocks the caller */
+    ret = calib_store_put(algo_calib_store_id(magic), &profile,
+                          sizeof(calibprofile_crc_t));
+    if (ret) {
+        PERR("save caliration profile failed:%s\n", filename);
     }
 #else
     ts_calibprofile profile;
@@ -1372,12 +1464,16 @@ void algo_save_calib_profile(char magic) {
 #endif
 }
 
-BS_S32 algo_proc_data(uint32_t ts) {
-    int err = 0;
+/*
+ * sample stage of the fusion: read the sensors due at ts into frame,
+ * which must hold a libraryinput_t
+ */
+BS_S32 algo_sample_data(uint32_t ts, void *frame) {
     int ret = 0;
 #ifdef CFG_USE_DATA_LOG
     char line[256] = "";
 #endif
+    /* sensors not due at ts keep the values of their last sample */
     static libraryinput_t all_sensor_data;
 
     /* read all sensor data */
@@ -1423,7 +1519,72 @@ BS_S32 algo_proc_data(uint32_t ts) {
     }
 #endif
 
-    bsx_dostep(&all_sensor_data);
+    memcpy(frame, &all_sensor_data, sizeof(all_sensor_data));
+    return 0;
+}
+
+
+#if __HAL_VER__ >= __SENSORS_DEVICE_API_VERSION_1_0__
+/* flag the step products whose output changed with the last step */
+static void algo_check_steps() {
+    uint64_t steps = 0;
+    uint8_t step_status = 0;
+    uint32_t reset = __atomic_exchange_n(&g_step_reset, 0, __ATOMIC_ACQUIRE);
+
+    if (reset & (1 << SENSOR_TYPE_STC)) {
+        g_steps = (uint64_t) -1;
+    }
+    if (reset & (1 << SENSOR_TYPE_STD)) {
+        g_step_status = 0;
+    }
+
+    if (g_active_aps & (1 << SENSOR_TYPE_STC)) {
+        bsx_get_stepcount(&steps);
+        if (steps != g_steps) {
+            g_steps = steps;
+            g_changed_aps |= (1 << SENSOR_TYPE_STC);
+        }
+    }
+
+    if (g_active_aps & (1 << SENSOR_TYPE_STD)) {
+        (void) bsx_get_stepdetectionstatus(&step_status);
+        /* only a valid status is reported as a step */
+        if ((step_status != g_step_status) && step_status) {
+            g_changed_aps |= (1 << SENSOR_TYPE_STD);
+        }
+        g_step_status = step_status;
+    }
+}
+#endif
+
+
+/* fusion stage: run the library on a frame filled by algo_sample_data */
+void algo_fuse_data(void *frame) {
+    bsx_dostep((libraryinput_t *) frame);
+#if __HAL_VER__ >= __SENSORS_DEVICE_API_VERSION_1_0__
+    algo_check_steps();
+#endif
+}
+
+
+uint32_t algo_get_changed_products() {
+    uint32_t changed = g_changed_aps;
+
+    /* set and cleared by the same thread, the one running the fusion */
+    g_changed_aps = 0;
+    return changed;
+}
+
+
+BS_S32 algo_proc_data(uint32_t ts) {
+    libraryinput_t frame;
+    BS_S32 err;
+
+    err = algo_sample_data(ts, &frame);
+    if (!err) {
+        algo_fuse_data(&frame);
+    }
+
     return err;
 }
 
@@ -1769,47 +1930,18 @@ int algo_get_proc_data_sgm(sensor_data_t *pdata) {
 }
 
 int algo_get_proc_data_stc(sensor_data_t *pdata) {
-    int ret = 0;
-    uint64_t steps = 0;
-    static uint64_t pre_steps = 0;
-
-    bsx_get_stepcount(&steps);
-
-    if (pre_steps != steps) {
-        pdata->step_counter = steps;
-        pre_steps = steps;
-        ret = 1;
-        PINFO("get step counter %lld pre_steps %lld", pdata->step_counter, pre_steps);
-
-    }
-
-    return ret;
+    pdata->step_counter = g_steps;
+    PINFO("get step counter %lld", pdata->step_counter);
 
+    return 1;
 }
 
 int algo_get_proc_data_std(sensor_data_t *pdata) {
-    int ret = 0;
-    uint8_t step_status = 0;
-    static uint8_t pre_step_status = 0;
-
-    (void) bsx_get_stepdetectionstatus(&step_status);
-
-    if (pre_step_status != step_status) {
-        /* if not a valid status then won't report
-           it as a step detector event*/
-        if (step_status == 0) {
-            pre_step_status = step_status;
-            return 0;
-        }
-        pdata->data[0] = step_status;
-        pdata->data[1] = 0;
-        pdata->data[2] = 0;
-        pre_step_status = step_status;
-        ret = 1;
+    pdata->data[0] = g_step_status;
+    pdata->data[1] = 0;
+    pdata->data[2] = 0;
 
-    }
-
-    return ret;
+    return 1;
 }
 
 #endif
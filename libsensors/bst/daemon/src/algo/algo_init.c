@@ -88,8 +88,6 @@
 
 #include "sensord.h"
 
-#define ALGO_SOFTIRON_MATRIX           "softiron_matrix.txt"
-
 extern const ts_sensmatrix softiron_default;
 extern const unsigned char bma_spec[];
 extern const unsigned char bmg160_spec[];
@@ -122,6 +120,7 @@ void algo_sensor_profile_init(void)
     remove((char*)SENSOR_CFG_FILE_SYS_PROFILE_CALIB_A);
     remove((char*)SENSOR_CFG_FILE_SYS_PROFILE_CALIB_M);
     remove((char*)SENSOR_CFG_FILE_SYS_PROFILE_CALIB_G);
+    calib_store_clear();
 }
 #endif
 
@@ -226,6 +225,44 @@ int algo_init_load_f32(const char *filename, BSX_F32 **pp_matrix, int num) {
     return err;
 }
 
+#ifdef __SOFTIRON_SUPPORT__
+/*!
+ * @brief This function gets the softiron matrix from the config snapshot,
+ * or parses the text file and records the result in the snapshot
+ *
+ * @param pp_matrix   malloc'ed matrix of 9 floats on success
+ *
+ * @return 0 success, < 0 failed
+ */
+static int algo_load_softiron(BSX_F32 **pp_matrix) {
+    BSX_F32 matrix[9];
+    int ret;
+
+    ret = cfg_snapshot_get(CFG_SNAPSHOT_SOFTIRON, matrix, sizeof(matrix));
+    if ((int) sizeof(matrix) == ret) {
+        *pp_matrix = malloc(sizeof(matrix));
+        if (NULL == *pp_matrix) {
+            return -1;
+        }
+
+        memcpy(*pp_matrix, matrix, sizeof(matrix));
+        return 0;
+    } else if (0 == ret) {
+        return -1;
+    }
+
+    ret = algo_init_load_f32(SENSOR_CFG_FILE_PATH ALGO_SOFTIRON_MATRIX,
+                             pp_matrix, 9);
+    if (ret) {
+        cfg_snapshot_put(CFG_SNAPSHOT_SOFTIRON, NULL, 0);
+    } else {
+        cfg_snapshot_put(CFG_SNAPSHOT_SOFTIRON, *pp_matrix, sizeof(matrix));
+    }
+
+    return ret;
+}
+#endif
+
 /*!
  * @brief This function initialize paramters for bsx library,
  *
@@ -282,6 +319,22 @@ int algo_init_parameters(void) {
  *
  * @return 0 success, < 0 failed
  */
+static void algo_apply_cust_param(const struct cfg_algo_cust *cust) {
+    g_compass_heading_sensitivity = cust->param[0];
+    g_ndof_ori_correct_speed = cust->param[1];
+    g_mag_filt_mode = cust->param[2];
+    g_mag_calib_speed = cust->param[3];
+    g_mag_calib_acc_sensitivity = cust->param[4];
+    g_compass_magcalib_autorecmode = cust->param[5];
+    g_process_noise_diag[0] = cust->noise[0];
+    g_process_noise_diag[1] = cust->noise[1];
+    g_process_noise_diag[2] = cust->noise[2];
+    g_process_noise_diag[3] = cust->noise[3];
+    g_acc_filt_param1 = cust->acc_filt[0];
+    g_acc_filt_param2 = cust->acc_filt[1];
+}
+
+
 static void algo_load_cust_param(void) {
     char *filename = SENSOR_CFG_FILE_ALGO;
 
@@ -291,6 +344,18 @@ static void algo_load_cust_param(void) {
     int p[20];
     float noise[4] = {0.0};
     float acc_filt_param1 = -1.0, acc_filt_param2 = -1.0;
+    struct cfg_algo_cust cust;
+    int i;
+
+    ret = cfg_snapshot_get(CFG_SNAPSHOT_ALGO_CUST, &cust, sizeof(cust));
+    if ((int) sizeof(cust) == ret) {
+        PINFO("config of param from snapshot");
+        algo_apply_cust_param(&cust);
+        return;
+    } else if (0 == ret) {
+        PINFO("no cfg for algo in snapshot");
+        return;
+    }
 
     fd = open(filename, O_RDONLY);
     if (-1 != fd) {
@@ -310,18 +375,18 @@ static void algo_load_cust_param(void) {
                       p[0], p[1], p[2], p[3], p[4], p[5],
                       noise[0], noise[1], noise[2], noise[3],
                       acc_filt_param1, acc_filt_param2);
-                g_compass_heading_sensitivity = p[0];
-                g_ndof_ori_correct_speed = p[1];
-                g_mag_filt_mode = p[2];
-                g_mag_calib_speed = p[3];
-                g_mag_calib_acc_sensitivity = p[4];
-                g_compass_magcalib_autorecmode = p[5];
-                g_process_noise_diag[0] = noise[0];
-                g_process_noise_diag[1] = noise[1];
-                g_process_noise_diag[2] = noise[2];
-                g_process_noise_diag[3] = noise[3];
-                g_acc_filt_param1 = acc_filt_param1;
-                g_acc_filt_param2 = acc_filt_param2;
+                for (i = 0; i < ARRAY_SIZE(cust.param); i++) {
+                    cust.param[i] = p[i];
+                }
+                for (i = 0; i < ARRAY_SIZE(cust.noise); i++) {
+                    cust.noise[i] = noise[i];
+                }
+                cust.acc_filt[0] = acc_filt_param1;
+                cust.acc_filt[1] = acc_filt_param2;
+
+                algo_apply_cust_param(&cust);
+                cfg_snapshot_put(CFG_SNAPSHOT_ALGO_CUST, &cust, sizeof(cust));
+                return;
             }
             else {
                 PERR("invalid content: %s", buf);
@@ -334,6 +399,8 @@ static void algo_load_cust_param(void) {
     else {
         PINFO("no cfg file for algo");
     }
+
+    cfg_snapshot_put(CFG_SNAPSHOT_ALGO_CUST, NULL, 0);
 }
 
 /*!
@@ -468,8 +535,7 @@ int algo_init(void) {
     }
 
 #ifdef __SOFTIRON_SUPPORT__
-    err = algo_init_load_f32(SENSOR_CFG_FILE_PATH ALGO_SOFTIRON_MATRIX,
-                             (BSX_F32**)&softiron_matrix, 9);
+    err = algo_load_softiron(&softiron_matrix);
     if (err)
     {
         PWARN("failed to load softiron matrix:%d, use default\n", err);
@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define LOG_TAG_MODULE "<calib_store>"
+
+#include "sensord.h"
+
+#define CALIB_STORE_MAGIC 0x524c4143 /* "CALR" */
+#define CALIB_STORE_FILE_TMP (PATH_DIR_SENSOR_STORAGE "/calib_journal.tmp")
+/* compact the journal once it holds this many records */
+#define CALIB_STORE_MAX_RECORDS 128
+/* updates arriving within this window go out in one write */
+#define CALIB_STORE_BATCH_US 200000
+
+struct calib_record {
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t id;
+    uint16_t len;
+    uint8_t data[CALIB_STORE_DATA_SIZE];
+    /* crc32 of all the fields above */
+    uint32_t crc;
+};
+
+static struct calib_record g_records[CALIB_STORE_MAX];
+/* ids updated in memory but not written yet */
+static uint32_t g_dirty;
+static uint32_t g_seq;
+static int g_num_records;
+static int g_clear;
+/* the config snapshot has items to write out */
+static int g_snapshot;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+
+static uint32_t calib_store_crc(const struct calib_record *rec) {
+    return util_crc32(0, rec, OFFSET_OF(struct calib_record, crc));
+}
+
+
+static int calib_store_write_all(int fd, const void *buf, int size) {
+    const uint8_t *p = (const uint8_t *) buf;
+    int n;
+
+    while (size > 0) {
+        n = write(fd, p, size);
+        if (n < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return -errno;
+        }
+
+        p += n;
+        size -= n;
+    }
+
+    return 0;
+}
+
+
+/* rewrite the journal with only the latest record of each profile */
+static int calib_store_compact(const struct calib_record *recs, int num) {
+    int fd;
+    int err;
+
+    fd = open(CALIB_STORE_FILE_TMP, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+              S_IRUSR | S_IWUSR);
+    if (-1 == fd) {
+        PWARN("error creating calib journal: %d", errno);
+        return -errno;
+    }
+
+    err = calib_store_write_all(fd, recs, num * sizeof(*recs));
+    if (!err && fsync(fd)) {
+        err = -errno;
+    }
+    close(fd);
+
+    if (!err && rename(CALIB_STORE_FILE_TMP, CALIB_STORE_FILE)) {
+        err = -errno;
+    }
+
+    if (err) {
+        PWARN("error compacting calib journal: %d", err);
+        unlink(CALIB_STORE_FILE_TMP);
+    }
+
+    return err;
+}
+
+
+static int calib_store_append(const struct calib_record *recs, int num) {
+    int fd;
+    int err;
+
+    fd = open(CALIB_STORE_FILE, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+              S_IRUSR | S_IWUSR);
+    if (-1 == fd) {
+        PWARN("error opening calib journal: %d", errno);
+        return -errno;
+    }
+
+    err = calib_store_write_all(fd, recs, num * sizeof(*recs));
+    if (!err && fdatasync(fd)) {
+        err = -errno;
+    }
+    close(fd);
+
+    if (err) {
+        PWARN("error appending to calib journal: %d", err);
+    }
+
+    return err;
+}
+
+
+static void *calib_store_proc(void *arg) {
+    struct calib_record recs[CALIB_STORE_MAX];
+    /* left over by a failed write, retried with the next update */
+    uint32_t unsaved = 0;
+    int compact = 0;
+    uint32_t dirty;
+    int snapshot;
+    int num;
+    int err;
+    int i;
+
+    (void) arg;
+
+    while (1) {
+        pthread_mutex_lock(&g_lock);
+        while (!g_dirty && !g_clear && !g_snapshot) {
+            pthread_cond_wait(&g_cond, &g_lock);
+        }
+        pthread_mutex_unlock(&g_lock);
+
+        /* the profiles of all the sensors are usually saved together */
+        eusleep(CALIB_STORE_BATCH_US);
+
+        pthread_mutex_lock(&g_lock);
+        if (g_clear) {
+            compact = 1;
+            unsaved = 0;
+        }
+        dirty = g_dirty | unsaved;
+        snapshot = g_snapshot;
+        g_dirty = 0;
+        g_clear = 0;
+        g_snapshot = 0;
+
+        num = 0;
+        for (i = 0; i < CALIB_STORE_MAX; i++) {
+            if ((compact || (dirty & (1 << i))) && g_records[i].len) {
+                recs[num++] = g_records[i];
+            }
+        }
+        pthread_mutex_unlock(&g_lock);
+
+        if (snapshot) {
+            cfg_snapshot_commit();
+        }
+
+        if (!compact && !num) {
+            unsaved = 0;
+            continue;
+        }
+
+        if (compact || (g_num_records + num > CALIB_STORE_MAX_RECORDS)) {
+            err = calib_store_compact(recs, num);
+            if (!err) {
+                g_num_records = num;
+                compact = 0;
+            }
+        } else {
+            err = calib_store_append(recs, num);
+            if (!err) {
+                g_num_records += num;
+            }
+        }
+
+        unsaved = err ? dirty : 0;
+    }
+
+    return NULL;
+}
+
+
+static void calib_store_restore() {
+    struct calib_record rec;
+    int num_valid = 0;
+    int num = 0;
+    int torn = 0;
+    int fd;
+    int n;
+
+    fd = open(CALIB_STORE_FILE, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd) {
+        PINFO("no calib journal yet");
+        return;
+    }
+
+    while (sizeof(rec) == (size_t) (n = read(fd, &rec, sizeof(rec)))) {
+        num++;
+        if ((CALIB_STORE_MAGIC != rec.magic)
+                || (rec.id >= CALIB_STORE_MAX)
+                || (rec.len > CALIB_STORE_DATA_SIZE)
+                || (calib_store_crc(&rec) != rec.crc)) {
+            torn = 1;
+            continue;
+        }
+
+        if (!g_records[rec.id].len
+                || ((int32_t) (rec.seq - g_records[rec.id].seq) > 0)) {
+            g_records[rec.id] = rec;
+        }
+
+        if ((int32_t) (rec.seq - g_seq) >= 0) {
+            g_seq = rec.seq + 1;
+        }
+        num_valid++;
+    }
+    close(fd);
+
+    if (n) {
+        torn = 1;
+    }
+
+    PINFO("calib journal: %d valid of %d records%s",
+          num_valid, num, torn ? ", torn" : "");
+
+    g_num_records = num;
+    if (torn) {
+        /* get rid of the damage before appending to it */
+        g_clear = 1;
+    }
+}
+
+
+int calib_store_init(void) {
+    pthread_t tid;
+    int err;
+
+    calib_store_restore();
+
+    err = pthread_create(&tid, NULL, calib_store_proc, NULL);
+    if (err) {
+        PERR("error creating calib store thread");
+        return -err;
+    }
+
+    pthread_detach(tid);
+
+    if (g_clear) {
+        pthread_cond_signal(&g_cond);
+    }
+
+    return 0;
+}
+
+
+int calib_store_get(int id, void *buf, int size) {
+    int len = -ENOENT;
+
+    if ((id < 0) || (id >= CALIB_STORE_MAX)) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    if (g_records[id].len && (g_records[id].len <= size)) {
+        len = g_records[id].len;
+        memcpy(buf, g_records[id].data, len);
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    return len;
+}
+
+
+int calib_store_put(int id, const void *buf, int len) {
+    struct calib_record *rec;
+
+    if ((id < 0) || (id >= CALIB_STORE_MAX)
+            || (len <= 0) || (len > CALIB_STORE_DATA_SIZE)) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    rec = &g_records[id];
+    if ((rec->len == len) && !memcmp(rec->data, buf, len)) {
+        /* nothing new, spare the flash */
+        pthread_mutex_unlock(&g_lock);
+        return 0;
+    }
+
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = CALIB_STORE_MAGIC;
+    rec->seq = g_seq++;
+    rec->id = id;
+    rec->len = len;
+    memcpy(rec->data, buf, len);
+    rec->crc = calib_store_crc(rec);
+
+    g_dirty |= (1 << id);
+    pthread_cond_signal(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+
+    return 0;
+}
+
+
+void calib_store_clear(void) {
+    pthread_mutex_lock(&g_lock);
+    memset(g_records, 0, sizeof(g_records));
+    g_dirty = 0;
+    g_clear = 1;
+    pthread_cond_signal(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+}
+
+
+void calib_store_sync_snapshot(void) {
+    pthread_mutex_lock(&g_lock);
+    g_snapshot = 1;
+    pthread_cond_signal(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define LOG_TAG_MODULE "<cfg_snapshot>"
+
+#include "sensord.h"
+#include "input_registry.h"
+
+#define CFG_SNAPSHOT_MAGIC 0x50534e53 /* "SNSP" */
+/* bump on any change of the layout below */
+#define CFG_SNAPSHOT_VERSION 1
+#define CFG_SNAPSHOT_INPUT_DEVS 32
+#define CFG_SNAPSHOT_FILE_TMP (PATH_DIR_SENSOR_STORAGE "/cfg_snapshot.tmp")
+
+struct cfg_snapshot_src {
+    int64_t mtime_ns;
+    /* -1 when the file did not exist */
+    int64_t size;
+};
+
+struct cfg_snapshot_entry {
+    struct cfg_snapshot_src src;
+    /* -1: not recorded */
+    int32_t len;
+    uint8_t data[CFG_SNAPSHOT_ITEM_SIZE];
+};
+
+struct cfg_snapshot {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    /* crc32 of everything after this field */
+    uint32_t crc;
+
+    struct cfg_snapshot_entry items[CFG_SNAPSHOT_ITEM_MAX];
+
+    int32_t num_input_devs;
+    struct input_dev_info input_devs[CFG_SNAPSHOT_INPUT_DEVS];
+};
+
+static const char *const g_item_src[CFG_SNAPSHOT_ITEM_MAX] = {
+    [CFG_SNAPSHOT_AXIS] = SENSOR_CFG_FILE_SYS_AXIS,
+    [CFG_SNAPSHOT_ALGO_CUST] = SENSOR_CFG_FILE_ALGO,
+    [CFG_SNAPSHOT_SOFTIRON] = SENSOR_CFG_FILE_PATH ALGO_SOFTIRON_MATRIX,
+    [CFG_SNAPSHOT_CALIB_A] = SENSOR_CFG_FILE_SYS_PROFILE_CALIB_A,
+    [CFG_SNAPSHOT_CALIB_M] = SENSOR_CFG_FILE_SYS_PROFILE_CALIB_M,
+    [CFG_SNAPSHOT_CALIB_G] = SENSOR_CFG_FILE_SYS_PROFILE_CALIB_G,
+};
+
+/* the valid items of the last run plus the ones resolved since */
+static struct cfg_snapshot g_snap;
+/* items of g_snap that can be used */
+static uint32_t g_valid;
+static int g_dirty;
+static int g_committed;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+/* one writer of the file at a time, never held with g_lock */
+static pthread_mutex_t g_write_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void cfg_snapshot_stat(const char *path, struct cfg_snapshot_src *src) {
+    struct stat st;
+
+    if (stat(path, &st)) {
+        src->mtime_ns = 0;
+        src->size = -1;
+        return;
+    }
+
+    src->mtime_ns = (int64_t) st.st_mtim.tv_sec * TIME_SCALE_S2NS
+                    + st.st_mtim.tv_nsec;
+    src->size = st.st_size;
+}
+
+
+static uint32_t cfg_snapshot_crc(const struct cfg_snapshot *snap) {
+    const uint8_t *start = (const uint8_t *) &snap->crc + sizeof(snap->crc);
+
+    return util_crc32(0, start, (const uint8_t *) (snap + 1) - start);
+}
+
+
+static const struct cfg_snapshot *cfg_snapshot_map() {
+    const struct cfg_snapshot *snap;
+    struct stat st;
+    void *addr;
+    int fd;
+
+    fd = open(CFG_SNAPSHOT_FILE, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd) {
+        PINFO("no config snapshot yet");
+        return NULL;
+    }
+
+    if (fstat(fd, &st) || (sizeof(*snap) != (size_t) st.st_size)) {
+        PWARN("config snapshot of wrong size ignored");
+        close(fd);
+        return NULL;
+    }
+
+    addr = mmap(NULL, sizeof(*snap), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == addr) {
+        PWARN("error mapping config snapshot: %d", errno);
+        return NULL;
+    }
+
+    snap = (const struct cfg_snapshot *) addr;
+    if ((CFG_SNAPSHOT_MAGIC != snap->magic)
+            || (CFG_SNAPSHOT_VERSION != snap->version)
+            || (sizeof(*snap) != snap->size)
+            || (cfg_snapshot_crc(snap) != snap->crc)) {
+        PWARN("config snapshot is corrupted or outdated, ignored");
+        munmap(addr, sizeof(*snap));
+        return NULL;
+    }
+
+    return snap;
+}
+
+
+void cfg_snapshot_load(void) {
+    const struct cfg_snapshot *snap;
+    struct cfg_snapshot_src src;
+    int i;
+
+    for (i = 0; i < CFG_SNAPSHOT_ITEM_MAX; i++) {
+        g_snap.items[i].len = -1;
+    }
+
+    snap = cfg_snapshot_map();
+    if (NULL == snap) {
+        g_dirty = 1;
+        return;
+    }
+
+    for (i = 0; i < CFG_SNAPSHOT_ITEM_MAX; i++) {
+        cfg_snapshot_stat(g_item_src[i], &src);
+        if ((-1 != snap->items[i].len)
+                && (src.mtime_ns == snap->items[i].src.mtime_ns)
+                && (src.size == snap->items[i].src.size)) {
+            g_snap.items[i] = snap->items[i];
+            g_valid |= (1 << i);
+        } else {
+            PINFO("%s changed, resolving it again", g_item_src[i]);
+            g_dirty = 1;
+        }
+    }
+
+    if ((snap->num_input_devs > 0)
+            && (snap->num_input_devs <= CFG_SNAPSHOT_INPUT_DEVS)) {
+        input_registry_seed(snap->input_devs, snap->num_input_devs);
+    }
+
+    munmap((void *) snap, sizeof(*snap));
+    PINFO("config snapshot loaded, valid items: 0x%x", g_valid);
+}
+
+
+int cfg_snapshot_get(int item, void *buf, int size) {
+    const struct cfg_snapshot_entry *entry;
+    int len = -ENOENT;
+
+    pthread_mutex_lock(&g_lock);
+    if (g_valid & (1 << item)) {
+        entry = &g_snap.items[item];
+        if (entry->len <= size) {
+            memcpy(buf, entry->data, entry->len);
+            len = entry->len;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    return len;
+}
+
+
+void cfg_snapshot_put(int item, const void *buf, int len) {
+    struct cfg_snapshot_entry *entry;
+    int sync;
+
+    if ((len < 0) || (len > CFG_SNAPSHOT_ITEM_SIZE)) {
+        PWARN("item %d of %d bytes not recorded", item, len);
+        return;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    entry = &g_snap.items[item];
+    cfg_snapshot_stat(g_item_src[item], &entry->src);
+    memset(entry->data, 0, sizeof(entry->data));
+    memcpy(entry->data, buf, len);
+    entry->len = len;
+    /* the next get is served from here rather than the source */
+    g_valid |= (1 << item);
+    /* items resolved after the start up, e.g. calibration profiles
+     * loaded when a sensor is enabled, are written by the calib store
+     * thread, the command path must not wait for the storage */
+    sync = g_committed;
+    g_dirty = 1;
+    pthread_mutex_unlock(&g_lock);
+
+    if (sync) {
+        calib_store_sync_snapshot();
+    }
+}
+
+
+void cfg_snapshot_commit(void) {
+    static struct cfg_snapshot snap;
+    const char *path = CFG_SNAPSHOT_FILE_TMP;
+    int fd;
+    int n;
+
+    pthread_mutex_lock(&g_write_lock);
+
+    /* the registry may rescan, keep that out of g_lock */
+    n = input_registry_export(snap.input_devs, CFG_SNAPSHOT_INPUT_DEVS);
+
+    pthread_mutex_lock(&g_lock);
+    g_committed = 1;
+    if (!g_dirty) {
+        pthread_mutex_unlock(&g_lock);
+        pthread_mutex_unlock(&g_write_lock);
+        return;
+    }
+    memcpy(snap.items, g_snap.items, sizeof(snap.items));
+    g_dirty = 0;
+    pthread_mutex_unlock(&g_lock);
+
+    snap.num_input_devs = n;
+    snap.magic = CFG_SNAPSHOT_MAGIC;
+    snap.version = CFG_SNAPSHOT_VERSION;
+    snap.size = sizeof(snap);
+    snap.crc = cfg_snapshot_crc(&snap);
+
+    /* write aside and rename, a crash never leaves a torn snapshot */
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+              S_IRUSR | S_IWUSR);
+    if (-1 == fd) {
+        PWARN("error creating config snapshot: %d", errno);
+        goto exit_err;
+    }
+
+    n = write(fd, &snap, sizeof(snap));
+    if ((sizeof(snap) != (size_t) n) || fsync(fd)) {
+        PWARN("error writing config snapshot: %d", errno);
+        close(fd);
+        unlink(path);
+        goto exit_err;
+    }
+    close(fd);
+
+    if (rename(path, CFG_SNAPSHOT_FILE)) {
+        PWARN("error renaming config snapshot: %d", errno);
+        unlink(path);
+        goto exit_err;
+    }
+
+    PINFO("config snapshot written");
+    pthread_mutex_unlock(&g_write_lock);
+    return;
+
+exit_err:
+    /* tried again with the next item resolved */
+    pthread_mutex_lock(&g_lock);
+    g_dirty = 1;
+    pthread_mutex_unlock(&g_lock);
+    pthread_mutex_unlock(&g_write_lock);
+}
@@ -102,8 +102,10 @@
 #include "sensord.h"
 
 
-#ifdef CFG_CHECK_DISPLAY_STATE  /* deprecated */
+#ifdef CFG_CHECK_DISPLAY_STATE
 static pthread_mutex_t g_mutex_display_state = PTHREAD_MUTEX_INITIALIZER;
+/* the event handler keeps the pointer */
+static display_event_handler_t g_display_event_handler;
 #endif
 
 extern int g_fd_fifo_cmd;
@@ -114,6 +116,9 @@ static int channel_set_state(struct channel *ch, enum CHANNEL_STATE state, int s
 
 extern struct channel g_list_ch[];
 
+/* channels and control entries switched at once */
+#define CHANNEL_SWITCH_MAX 32
+
 static int channel_hdl2idx(int handle) {
     int i = -1;
 
@@ -159,11 +164,15 @@ int channel_get_state(int handle) {
 }
 
 
-static int channel_set_state(struct channel *ch, enum CHANNEL_STATE state, int src) {
-    int err = 0;
-    struct sensor_provider *sp = ch->sp;
+/*
+ * first half of a state change, leaves ch->lock_state held when it does
+ * not fail. returns 1 if the channel is to be switched on/off, which is
+ * then pending the reconfiguration of its provider
+ */
+static int channel_set_state_begin(struct channel *ch,
+                                   enum CHANNEL_STATE state, int src) {
+    int toggle = 0;
 
-    PDEBUG("function entry");
     UNUSED_PARAM(src);
     pthread_mutex_lock(&ch->lock_state);
 
@@ -176,40 +185,67 @@ static int channel_set_state(struct channel *ch, enum CHANNEL_STATE state, int s
 
     switch (state) {
     case CHANNEL_STATE_SLEEP:
-        if (CHANNEL_STATE_SLEEP != ch->state) {
-            sp_enable_ch(sp, ch, 0);
-            if (ch->enable) {
-                ch->enable(ch, 0);
-            }
-        }
+        toggle = (CHANNEL_STATE_SLEEP != ch->state);
         break;
     case CHANNEL_STATE_NORMAL:
     case CHANNEL_STATE_BG:
-        if (CHANNEL_STATE_SLEEP == ch->state) {
+        toggle = (CHANNEL_STATE_SLEEP == ch->state);
+        if (toggle) {
             /*  initialize the first frame,
                     avoiding the first frame show a very long duration value
                     in sensorlist. */
             ch->ts_last_ev = get_current_timestamp();
-            sp_enable_ch(sp, ch, 1);
-            if (ch->enable) {
-                ch->enable(ch, 1);
-            }
         }
         break;
     default:
         PWARN("unknown state req");
-        err = -EINVAL;
-        break;
+        pthread_mutex_unlock(&ch->lock_state);
+        return -EINVAL;
+    }
+
+    if (toggle) {
+        sp_enable_ch_begin(ch->sp, ch, CHANNEL_STATE_SLEEP != state);
     }
 
-    if (!err) {
-        ch->prev_state = ch->state;
-        ch->state = state;
+    return toggle;
+}
+
+
+/* second half of a state change, once the provider is reconfigured */
+static void channel_set_state_end(struct channel *ch,
+                                  enum CHANNEL_STATE state, int toggle) {
+    int enable = (CHANNEL_STATE_SLEEP != state);
+
+    if (toggle) {
+        sp_enable_ch_end(ch->sp, ch, enable);
+        if (ch->enable) {
+            ch->enable(ch, enable);
+        }
     }
 
+    ch->prev_state = ch->state;
+    ch->state = state;
+
     pthread_mutex_unlock(&ch->lock_state);
+}
 
-    return err;
+
+static int channel_set_state(struct channel *ch, enum CHANNEL_STATE state, int src) {
+    int toggle;
+
+    PDEBUG("function entry");
+
+    toggle = channel_set_state_begin(ch, state, src);
+    if (toggle < 0) {
+        return toggle;
+    }
+
+    if (toggle) {
+        sp_reconfigure(ch->sp);
+    }
+    channel_set_state_end(ch, state, toggle);
+
+    return 0;
 }
 
 
@@ -312,12 +348,211 @@ int channel_on_cmd_received(int handle, int cmd, int value) {
 }
 
 
+static int channel_clamp_interval(const struct channel *ch, int value) {
+    if (value < ch->cfg.interval_min) {
+        value = ch->cfg.interval_min;
+    }
+
+    if (value > ch->cfg.interval_max) {
+        value = ch->cfg.interval_max;
+    }
+
+    return value;
+}
+
+
+static void channel_add_sp(struct sensor_provider **sps, int *num,
+                           struct sensor_provider *sp) {
+    int i;
+
+    for (i = 0; i < *num; i++) {
+        if (sp == sps[i]) {
+            return;
+        }
+    }
+
+    sps[(*num)++] = sp;
+}
+
+
+/*
+ * switch chs[i] to states[i] (-1: unchanged) and intervals[i] (0:
+ * unchanged) with one reconfiguration per provider involved, src is
+ * the reason as in channel_set_state()
+ */
+static int channel_switch_batch(struct channel *const *chs, const int *states,
+                                const int *intervals, int num, int src) {
+    struct sensor_provider *sps[CHANNEL_SWITCH_MAX];
+    int toggled[CHANNEL_SWITCH_MAX];
+    struct channel *ch;
+    int num_sp = 0;
+    int i;
+
+    if (num > CHANNEL_SWITCH_MAX) {
+        PERR("too many channels to switch: %d", num);
+        return 0;
+    }
+
+    for (i = 0; i < num; i++) {
+        if ((NULL != chs[i]) && ((-1 != states[i]) || intervals[i])) {
+            channel_add_sp(sps, &num_sp, chs[i]->sp);
+        }
+    }
+
+    for (i = 0; i < num_sp; i++) {
+        sp_hold_update(sps[i]);
+    }
+
+    for (i = 0; i < num; i++) {
+        ch = chs[i];
+        if ((NULL == ch) || !intervals[i]) {
+            continue;
+        }
+
+        PINFO("new interval for sensor %s is %d, request: %d",
+              ch->name, ch->interval, intervals[i]);
+        ch->sp->on_ch_interval_changed(ch,
+                channel_clamp_interval(ch, intervals[i]));
+    }
+
+    /* the channels switched stay locked until the providers are done */
+    for (i = 0; i < num; i++) {
+        ch = chs[i];
+        if ((NULL == ch) || (-1 == states[i])) {
+            toggled[i] = -1;
+            continue;
+        }
+
+        toggled[i] = channel_set_state_begin(ch,
+                (enum CHANNEL_STATE) states[i], src);
+    }
+
+    for (i = 0; i < num_sp; i++) {
+        sp_reconfigure(sps[i]);
+    }
+
+    for (i = 0; i < num; i++) {
+        if (toggled[i] < 0) {
+            continue;
+        }
+
+        channel_set_state_end(chs[i], (enum CHANNEL_STATE) states[i],
+                              toggled[i]);
+    }
+
+    return num_sp;
+}
+
+
+int channel_on_batch_received(const struct ctrl_entry *entries, int num,
+                              struct ctrl_result *results) {
+    struct channel *chs[CTRL_BATCH_MAX];
+    int states[CTRL_BATCH_MAX];
+    int intervals[CTRL_BATCH_MAX];
+    const struct ctrl_entry *e;
+    struct channel *ch;
+    int num_sp;
+    int i;
+    int j;
+
+    if ((num < 0) || (num > CTRL_BATCH_MAX)) {
+        return -EINVAL;
+    }
+
+    /* validate everything first, a bad entry is skipped as a whole */
+    for (i = 0; i < num; i++) {
+        e = entries + i;
+        results[i].handle = e->handle;
+        results[i].err = 0;
+        chs[i] = NULL;
+
+        ch = channel_get_ch(e->handle);
+        if (NULL == ch) {
+            results[i].err = -EINVAL;
+            continue;
+        }
+
+        if (!ch->cfg.availability) {
+            PWARN("cmd sent to a channel which is not available");
+            results[i].err = -ENODEV;
+            continue;
+        }
+
+        if ((e->flags & CTRL_F_DELAY) && (e->interval < SAMPLE_INTERVAL_MIN)) {
+            PWARN("invalid interval: %d", e->interval);
+            results[i].err = -EINVAL;
+            continue;
+        }
+
+        for (j = 0; j < i; j++) {
+            if (ch == chs[j]) {
+                PWARN("duplicated entry for %s", ch->name);
+                results[i].err = -EINVAL;
+                break;
+            }
+        }
+
+        if (results[i].err) {
+            continue;
+        }
+
+        chs[i] = ch;
+        states[i] = -1;
+        if (e->flags & CTRL_F_ACTIVE) {
+            states[i] = e->active ? CHANNEL_STATE_NORMAL : CHANNEL_STATE_SLEEP;
+        }
+        intervals[i] = (e->flags & CTRL_F_DELAY) ? e->interval : 0;
+    }
+
+    num_sp = channel_switch_batch(chs, states, intervals, num, 0);
+
+    for (i = 0; i < num; i++) {
+        ch = chs[i];
+        if ((NULL == ch) || !(entries[i].flags & CTRL_F_FLUSH)) {
+            continue;
+        }
+
+#if __HAL_VER__ >= __SENSORS_DEVICE_API_VERSION_1_1__
+        results[i].err = fifo_write_flush_finish_event(ch->handle);
+#else
+        results[i].err = -EINVAL;
+#endif
+    }
+
+    for (i = 0; i < num; i++) {
+        ch = chs[i];
+        if (NULL == ch) {
+            results[i].active = 0;
+            results[i].interval = 0;
+            continue;
+        }
+
+        results[i].active =
+                (CHANNEL_STATE_SLEEP != channel_get_state(ch->handle));
+        results[i].interval = ch->interval;
+    }
+
+    PINFO("batch of %d entries applied to %d providers", num, num_sp);
+
+    return 0;
+}
+
+
 #ifdef CFG_CHECK_DISPLAY_STATE
+/*
+ * display off: all channels but the proximity and the wake up ones go to
+ * sleep, the wake up ones drop to their lowest rate, so that only the
+ * h/w they need keeps running, at a low bandwidth. display on: all of
+ * them are restored. Either way it is a single reconfiguration.
+ */
 static int channel_on_display_state_change(int state)
 {
-    int err = 0;
-    int i = 0;
+    struct channel *chs[CHANNEL_SWITCH_MAX];
+    int states[CHANNEL_SWITCH_MAX];
+    int intervals[CHANNEL_SWITCH_MAX];
     struct channel *ch;
+    int num = 0;
+    int i = 0;
 
     PDEBUG("function entry");
 
@@ -325,38 +560,38 @@ static int channel_on_display_state_change(int state)
     pthread_mutex_lock(&g_mutex_display_state);
     PDEBUG("get hold of g_mutex_display_state");
 
-    if (state) {
-        PDEBUG("display is on");
-        PDEBUG("transition 1, 4");
-        for (i = 0; i < channel_get_num(); i++) {
-            ch = g_list_ch + i;
-            if (ch->cfg.availability) {
-                if (SENSOR_HANDLE_PROXIMITY != ch->handle) {
-                    PDEBUG("prev state of %s is: %d",
-                           ch->name,
-                           ch->prev_state);
-                    channel_set_state(ch,
-                                      ch->prev_state, 1);
-                }
-            }
+    PDEBUG("display is %s", state ? "on" : "off");
+    for (i = 0; (i < channel_get_num()) && (num < CHANNEL_SWITCH_MAX); i++) {
+        ch = g_list_ch + i;
+        if (!ch->cfg.availability
+                || (SENSOR_HANDLE_PROXIMITY == ch->handle)) {
+            continue;
         }
-    } else {
-        PDEBUG("display is off");
-        PDEBUG("transition 2, 6");
-        for (i = 0; i < channel_get_num(); i++) {
-            ch = g_list_ch + i;
-            if (ch->cfg.availability) {
-                if (SENSOR_HANDLE_PROXIMITY != ch->handle) {
-                    channel_set_state(ch,
-                                      CHANNEL_STATE_SLEEP, 1);
-                }
-            }
+
+        chs[num] = ch;
+        states[num] = -1;
+        intervals[num] = 0;
+
+        if (!ch->cfg.wake_up) {
+            states[num] = state ? ch->prev_state : CHANNEL_STATE_SLEEP;
+        } else if (state) {
+            intervals[num] = ch->interval_awake;
+            ch->interval_awake = 0;
+        } else if ((CHANNEL_STATE_SLEEP != ch->state)
+                && !ch->cfg.no_delay
+                && (ch->interval < ch->cfg.interval_max)) {
+            ch->interval_awake = ch->interval;
+            intervals[num] = ch->cfg.interval_max;
         }
+
+        num++;
     }
 
+    channel_switch_batch(chs, states, intervals, num, 1);
+
     pthread_mutex_unlock(&g_mutex_display_state);
     PDEBUG("release hold of g_mutex_display_state");
-    return err;
+    return 0;
 }
 #endif
 
@@ -445,9 +680,6 @@ void channel_subscribe2sp() {
 
 int channel_cntl_init() {
     int err = 0;
-#ifdef CFG_CHECK_DISPLAY_STATE
-    display_event_handler_t display_event_handler;
-#endif
     PDEBUG("function entry");
 
     /* sp_preinit will do initialize for bsx library and detect which kind
@@ -464,9 +696,9 @@ int channel_cntl_init() {
 
     channel_post_init();
 #ifdef CFG_CHECK_DISPLAY_STATE
-    display_event_handler.on_display_state_change =
+    g_display_event_handler.on_display_state_change =
         channel_on_display_state_change;
-    register_display_event_handler(&display_event_handler);
+    register_display_event_handler(&g_display_event_handler);
 #endif
 
     return err;
@@ -527,6 +759,7 @@ void channel_cntl_dump() {
         PINFO("data_status: %d", ch->data_status);
         PINFO("interval: %d", ch->interval);
         PINFO("ts_last_ev: %d", ch->ts_last_ev);
+        util_hist_dump("interval jitter", &ch->stat_jitter);
         PINFO("private_data: %p", ch->private_data);
     }
 
@@ -68,6 +68,7 @@ int channel_init_stc(struct channel *ch) {
     }
 
     ch->cfg.no_delay = 0;
+    ch->cfg.on_change = 1;
     ch->cfg.interval_min = CFG_DELAY_STC_MIN;
     ch->cfg.interval_max = CFG_DELAY_STC_MAX;
     ch->cfg.dep_hw = CFG_HW_DEP_STC;
@@ -231,6 +231,7 @@ struct channel g_list_ch[] = {
         {
             .availability = VIRTUAL,
             .calib_bg = 0,
+            .wake_up = 1,
             .sp_name = "SP_FUSION"
         },
 
@@ -248,6 +249,7 @@ struct channel g_list_ch[] = {
         {
             .availability = VIRTUAL,
             .calib_bg = 0,
+            .wake_up = 1,
             .sp_name = "SP_FUSION"
         },
 
@@ -334,6 +336,7 @@ struct channel g_list_ch[] = {
         {
             .availability = CFG_CHANNEL_STC,
             .calib_bg = 0,
+            .wake_up = 1,
             .sp_name = "SP_FUSION"
         },
 
@@ -350,6 +353,7 @@ struct channel g_list_ch[] = {
         {
             .availability = CFG_CHANNEL_STD,
             .calib_bg = 0,
+            .wake_up = 1,
             .sp_name = "SP_FUSION"
         },
 
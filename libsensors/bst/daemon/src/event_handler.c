@@ -128,6 +128,8 @@ pthread_t g_tid_check_display_state;
 
 
 display_event_handler_t *g_display_event_handler = NULL;
+/* assumed on until the kernel says otherwise */
+static int g_display_state = 1;
 #endif
 
 int g_fd_fifo_cmd = -1;
@@ -190,6 +192,23 @@ int fifo_read(void *data, int size) {
     return readn(g_fd_fifo_cmd, data, size);
 }
 
+/* reads and drops size bytes of the cmd fifo, through buf */
+static int fifo_discard(void *buf, int buf_size, int size) {
+    int n;
+    int ret;
+
+    while (size > 0) {
+        n = (size < buf_size) ? size : buf_size;
+        ret = fifo_read(buf, n);
+        if (n != ret) {
+            return (ret < 0) ? ret : -EIO;
+        }
+        size -= n;
+    }
+
+    return 0;
+}
+
 /*!
  * @brief This function send sensor handler list to hal
  */
@@ -206,6 +225,70 @@ int handler_get_handler_list(void) {
     return ret;
 }
 
+static void check_batch_event(const struct exchange *hdr) {
+    struct ctrl_entry entries[CTRL_BATCH_MAX];
+    struct {
+        struct exchange hdr;
+        struct ctrl_result results[CTRL_BATCH_MAX];
+    } ack;
+    int num = hdr->command.value;
+    int size = hdr->command.reserved[0];
+    int err = 0;
+    int ret;
+
+    if ((num < 0) || (num > CTRL_BATCH_MAX) || (size <= 0)
+            || (size > (int) sizeof(entries))) {
+        /* the rest of the stream can not be trusted any more */
+        PERR("corrupted cmd batch, num: %d size: %d", num, size);
+        return;
+    }
+
+    memset(&ack, 0, sizeof(ack));
+    if ((CTRL_PROTO_VERSION != hdr->command.cmd)
+            || ((int) sizeof(entries[0]) != size)
+            || (num * size > (int) sizeof(entries))) {
+        PWARN("unsupported cmd batch, version: %d size: %d",
+              hdr->command.cmd, size);
+        /* skip the payload, never more than entries at a time */
+        ret = fifo_discard(entries, sizeof(entries), num * size);
+        if (ret) {
+            PWARN("invalid cmd batch, %d %d", num * size, ret);
+            return;
+        }
+        err = -EPROTONOSUPPORT;
+        num = 0;
+    } else {
+        if (num) {
+            ret = fifo_read(entries, num * size);
+            if (num * size != ret) {
+                PWARN("invalid cmd batch, %d %d", num * size, ret);
+                return;
+            }
+        }
+
+        PDEBUG("cmd batch got: %d entries, seq: %d",
+               num, hdr->command.code);
+        err = channel_on_batch_received(entries, num, ack.results);
+        if (err) {
+            num = 0;
+        }
+    }
+
+    ack.hdr.magic = CHANNEL_PKT_MAGIC_ACK;
+    ack.hdr.command.cmd = CTRL_PROTO_VERSION;
+    ack.hdr.command.code = hdr->command.code;
+    ack.hdr.command.value = num;
+    ack.hdr.command.reserved[0] = err;
+
+    /* a single write, so that it is not interleaved with sensor data */
+    ret = fifo_write(&ack,
+                     sizeof(ack.hdr) + num * sizeof(struct ctrl_result));
+    if (ret) {
+        PWARN("error acking cmd batch %d: %d", hdr->command.code, ret);
+    }
+}
+
+
 void check_cmd_event() {
     struct exchange cmd;
     int ret;
@@ -228,6 +311,9 @@ void check_cmd_event() {
                                 cmd.command.cmd,
                                 cmd.command.value);
     }
+    else if (CHANNEL_PKT_MAGIC_BATCH == cmd.magic) {
+        check_batch_event(&cmd);
+    }
     else if (CHANNEL_PKT_MAGIC_LIST == cmd.magic) {
         ret = handler_get_handler_list();
         if (ret) {
@@ -257,10 +343,10 @@ int fifo_write_flush_finish_event(int handle) {
 #ifdef CFG_CHECK_DISPLAY_STATE
 static void notify_display_listeners(int state)
 {
-    int err;
-
     if (state == g_display_state) {
-        PINFO("state: %d same as before", state);
+        /* the wake file reads through at start up with the display on */
+        PDEBUG("state: %d same as before", state);
+        return;
     }
 
     PINFO("new display state: %d", state);
@@ -268,7 +354,7 @@ static void notify_display_listeners(int state)
 
     if (NULL != g_display_event_handler) {
         if (NULL != g_display_event_handler->on_display_state_change) {
-            err = g_display_event_handler->on_display_state_change(state);
+            (void) g_display_event_handler->on_display_state_change(state);
         }
     }
 
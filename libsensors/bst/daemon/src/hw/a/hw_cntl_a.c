@@ -109,6 +109,7 @@ static int g_fd_input_ev_a = -1;
 
 int g_place_a = HW_INFO_DFT_PLACE_A;
 extern struct axis_remap axis_remap_tab_a[8];
+static struct axis_conv g_conv_a;
 
 
 static const struct value_map map_a_range[HW_A_RANGE_MAX] = {
@@ -242,7 +243,7 @@ static int hw_acc_read_xyzdata(void *data) {
 
     err = hw_acc_read_xyzdata_fr(val);
     if (g_place_a >= 0) {
-        hw_remap_sensor_data(val, axis_remap_tab_a + g_place_a);
+        hw_remap_sensor_data(val, 1, &g_conv_a);
     }
 
     return err;
@@ -291,7 +292,7 @@ static int hw_acc_read_xyzdata_input_ev(void *data) {
     val->z = val->z >> (16 - HW_INFO_BITWIDTH_A);
 #endif
     if (g_place_a >= 0) {
-        hw_remap_sensor_data(val, axis_remap_tab_a + g_place_a);
+        hw_remap_sensor_data(val, 1, &g_conv_a);
     }
 
     return err;
@@ -461,6 +462,10 @@ static int hw_init_a(struct sensor_hw *hw) {
         err = 0;
     }
 
+    if (g_place_a >= 0) {
+        hw_remap_to_conv(axis_remap_tab_a + g_place_a, &g_conv_a);
+    }
+
     return err;
 }
 
@@ -108,6 +108,7 @@ static int g_fd_input_ev_g = -1;
 
 int g_place_g = HW_INFO_DFT_PLACE_G;
 extern struct axis_remap axis_remap_tab_g[8];
+static struct axis_conv g_conv_g;
 
 static const struct value_map map_g_range[HW_G_RANGE_MAX] = {
     {HW_G_RANGE_2000, 0},
@@ -170,7 +171,7 @@ static int hw_gyro_read_xyzdata_input_ev(void *data) {
     }
 
     if (g_place_g >= 0) {
-        hw_remap_sensor_data(val, axis_remap_tab_g + g_place_g);
+        hw_remap_sensor_data(val, 1, &g_conv_g);
     }
 
     return err;
@@ -203,7 +204,7 @@ static int hw_gyro_read_xyzdata(void *data) {
     }
 
     if (g_place_g >= 0) {
-        hw_remap_sensor_data(val, axis_remap_tab_g + g_place_g);
+        hw_remap_sensor_data(val, 1, &g_conv_g);
     }
 
     PDEBUG("[gyro] x: %d y: %d z: %d", val->x, val->y, val->z);
@@ -380,6 +381,10 @@ static int hw_init_g(struct sensor_hw *hw) {
 
     hw_init_g_settings(hw);
 
+    if (g_place_g >= 0) {
+        hw_remap_to_conv(axis_remap_tab_g + g_place_g, &g_conv_g);
+    }
+
     return err;
 }
 
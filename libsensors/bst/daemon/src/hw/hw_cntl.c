@@ -121,37 +121,30 @@ static const struct sensor_hw *g_list_hw[] = {
 };
 
 
-void hw_remap_sensor_data(sensor_data_ival_t *data, axis_remap_t *remap) {
-    sensor_data_ival_t tmp;
-    int t;
-
-    tmp.v[0] = data->v[0];
-    tmp.v[1] = data->v[1];
-    tmp.v[2] = data->v[2];
-
-    data->x = tmp.v[remap->rx];
-
-    t = tmp.v[0];
-    tmp.v[0] = tmp.v[1];
-    tmp.v[1] = t;
-    data->y = tmp.v[remap->ry];
-
-    t = tmp.v[0];
-    tmp.v[0] = tmp.v[2];
-    tmp.v[2] = t;
-    data->z = tmp.v[remap->rz];
-
-    if (remap->sx) {
-        data->x = 0 - data->x;
-    }
+void hw_remap_to_conv(const axis_remap_t *remap, struct axis_conv *conv) {
+    /* decode the swap sequence of the remap table:
+     * x picks from (v0, v1, v2), y from (v1, v0, v2), z from (v2, v0, v1)
+     */
+    static const int tab_y[3] = {1, 0, 2};
+    static const int tab_z[3] = {2, 0, 1};
+    int src[3];
+    int sign[3];
+
+    src[0] = remap->rx % 3;
+    src[1] = tab_y[remap->ry % 3];
+    src[2] = tab_z[remap->rz % 3];
+
+    sign[0] = remap->sx ? -1 : 1;
+    sign[1] = remap->sy ? -1 : 1;
+    sign[2] = remap->sz ? -1 : 1;
+
+    axis_conv_init(conv, src, sign, NULL);
+}
 
-    if (remap->sy) {
-        data->y = 0 - data->y;
-    }
 
-    if (remap->sz) {
-        data->z = 0 - data->z;
-    }
+void hw_remap_sensor_data(sensor_data_ival_t *data, int n,
+                          const struct axis_conv *conv) {
+    axis_conv_s32_s32(conv, data->v, data->v, n, ARRAY_SIZE(data->v));
 }
 
 
@@ -265,6 +258,11 @@ int hw_cntl_init() {
             hw->fd_poll = -1;
             hw->ts_last_update = 0;
 
+#ifdef __DEBUG_PIPELINE_BENCH__
+            /* a recorded trace stands in for the device */
+            bench_replay_attach(hw);
+#endif
+
             PINFO("init hw: %s, type: %d", hw->name, hw->type);
             err = hw->init(hw);
             if (err) {
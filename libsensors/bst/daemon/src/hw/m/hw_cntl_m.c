@@ -108,6 +108,7 @@ static int g_fd_input_ev_m = -1;
 
 int g_place_m = HW_INFO_DFT_PLACE_M;
 extern struct axis_remap axis_remap_tab_m[8];
+static struct axis_conv g_conv_m;
 
 struct bmm_cfg {
     int rept_xy;
@@ -194,7 +195,7 @@ static int hw_mag_read_xyzdata(void *data) {
     hw_mag_validate_val(val);
 
     if (g_place_m >= 0) {
-        hw_remap_sensor_data(val, axis_remap_tab_m + g_place_m);
+        hw_remap_sensor_data(val, 1, &g_conv_m);
     }
 
     PDEBUG("[mag] x: %hd y: %hd z: %hd", val->x, val->y, val->z);
@@ -240,7 +241,7 @@ static int hw_mag_read_xyzdata_input_ev(void *data) {
 
     hw_mag_validate_val(val);
     if (g_place_m >= 0) {
-        hw_remap_sensor_data(val, axis_remap_tab_m + g_place_m);
+        hw_remap_sensor_data(val, 1, &g_conv_m);
     }
 
     return err;
@@ -335,6 +336,10 @@ static int hw_init_m(struct sensor_hw *hw) {
 
     hw_init_m_settings(hw);
 
+    if (g_place_m >= 0) {
+        hw_remap_to_conv(axis_remap_tab_m + g_place_m, &g_conv_m);
+    }
+
     return err;
 }
 
@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <linux/input.h>
+
+#include <cutils/properties.h>
+
+#define LOG_TAG_MODULE "<util_bench>"
+
+#include "sensord.h"
+
+#ifdef __DEBUG_PIPELINE_BENCH__
+
+/* keep traces in memory, a minute of 200Hz 3-axis data is ~300KB */
+#define BENCH_TRACE_MAX_SIZE (4 * 1024 * 1024)
+
+struct bench_stage {
+    const char *name;
+    struct util_hist hist;
+};
+
+struct replay_sample {
+    sensor_data_ival_t val;
+    uint64_t ts;
+};
+
+struct replay_hw {
+    struct sensor_hw *hw;
+    struct input_event *ev;
+    size_t num_ev;
+    int fds[2];
+    int enabled;
+    pthread_mutex_t lock;
+    struct replay_sample latest;
+    uint32_t samples;
+};
+
+static struct bench_stage g_stages[BENCH_STAGE_MAX] = {
+    [BENCH_STAGE_SAMPLE] = { .name = "sample" },
+    [BENCH_STAGE_PROC] = { .name = "proc" },
+    [BENCH_STAGE_REPORT] = { .name = "report" },
+};
+
+static uint32_t g_wakeups;
+static int g_speed = 100;
+static struct replay_hw g_replay[SENSOR_HW_TYPE_MAX];
+
+uint64_t bench_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * TIME_SCALE_S2NS + ts.tv_nsec;
+}
+
+void bench_record(int stage, uint64_t ns) {
+    /* the stages are fed from several threads */
+    util_hist_add(&g_stages[stage].hist,
+                  (uint32_t) MIN(ns / 1000, UINT32_MAX));
+}
+
+void bench_wakeup(void) {
+    __atomic_add_fetch(&g_wakeups, 1, __ATOMIC_RELAXED);
+}
+
+static void bench_report(uint64_t elapse_ns) {
+    struct util_hist snap;
+    struct rusage usage;
+    uint32_t elapse_ms = (uint32_t) (elapse_ns / 1000000);
+    uint32_t wakeups;
+    int i;
+
+    if (!elapse_ms) {
+        return;
+    }
+
+    for (i = 0; i < BENCH_STAGE_MAX; i++) {
+        struct bench_stage *st = &g_stages[i];
+
+        util_hist_take(&st->hist, &snap);
+        if (!snap.count) {
+            continue;
+        }
+
+        PWARN("[bench] %-6s n: %u rate: %u/s avg: %uus p50: <%uus "
+              "p90: <%uus p99: <%uus max: %uus",
+              st->name, snap.count,
+              (uint32_t) ((uint64_t) snap.count * 1000 / elapse_ms),
+              (uint32_t) (snap.total / snap.count),
+              util_hist_percentile(&snap, 50),
+              util_hist_percentile(&snap, 90),
+              util_hist_percentile(&snap, 99),
+              snap.max);
+    }
+
+    wakeups = __atomic_exchange_n(&g_wakeups, 0, __ATOMIC_RELAXED);
+    if (!getrusage(RUSAGE_SELF, &usage)) {
+        PWARN("[bench] wakeups: %u/s cpu user: %ld.%03lds sys: %ld.%03lds",
+              (uint32_t) ((uint64_t) wakeups * 1000 / elapse_ms),
+              (long) usage.ru_utime.tv_sec, (long) usage.ru_utime.tv_usec / 1000,
+              (long) usage.ru_stime.tv_sec, (long) usage.ru_stime.tv_usec / 1000);
+    }
+}
+
+static void *bench_report_proc(void *arg) {
+    uint64_t last = bench_now_ns();
+    uint64_t now;
+
+    (void) arg;
+
+    while (1) {
+        sleep(BENCH_REPORT_PERIOD_S);
+        now = bench_now_ns();
+        bench_report(now - last);
+        last = now;
+    }
+
+    return NULL;
+}
+
+static uint64_t replay_ev_time_us(const struct input_event *ev) {
+    return (uint64_t) ev->time.tv_sec * TIME_SCALE_S2US + ev->time.tv_usec;
+}
+
+static void *replay_proc(void *arg) {
+    struct replay_hw *r = (struct replay_hw *) arg;
+    struct replay_sample sample;
+    uint64_t prev_us = 0;
+    uint64_t delta_us;
+    size_t i;
+    int err;
+
+    memset(&sample, 0, sizeof(sample));
+
+    while (1) {
+        for (i = 0; i < r->num_ev; i++) {
+            const struct input_event *ev = &r->ev[i];
+
+            if (EV_ABS == ev->type) {
+                switch (ev->code) {
+                case ABS_X:
+                    sample.val.x = ev->value;
+                    break;
+                case ABS_Y:
+                    sample.val.y = ev->value;
+                    break;
+                case ABS_Z:
+                    sample.val.z = ev->value;
+                    break;
+                }
+                continue;
+            }
+
+            if (EV_SYN != ev->type) {
+                continue;
+            }
+
+            /* keep the recorded pace, the first frame of a loop is not
+             * delayed */
+            delta_us = replay_ev_time_us(ev) - prev_us;
+            if (prev_us && replay_ev_time_us(ev) > prev_us &&
+                    delta_us < TIME_SCALE_S2US) {
+                eusleep((uint32_t) (delta_us * 100 / g_speed));
+            }
+            prev_us = replay_ev_time_us(ev);
+
+            if (!__atomic_load_n(&r->enabled, __ATOMIC_RELAXED)) {
+                continue;
+            }
+
+            sample.ts = bench_now_ns();
+            pthread_mutex_lock(&r->lock);
+            r->latest = sample;
+            r->samples++;
+            pthread_mutex_unlock(&r->lock);
+
+            /* nobody reading the pipe just means the sample is dropped */
+            err = write(r->fds[1], &sample, sizeof(sample));
+            (void) err;
+        }
+        prev_us = 0;
+    }
+
+    return NULL;
+}
+
+static int replay_get_data_nb(struct replay_hw *r, void *data) {
+    sensor_data_ival_t *val = (sensor_data_ival_t *) data;
+    struct replay_sample sample;
+    uint32_t samples;
+
+    /* the pipe only feeds get_data() and the readiness poll */
+    while (read(r->fds[0], &sample, sizeof(sample)) > 0) {
+    }
+
+    pthread_mutex_lock(&r->lock);
+    sample = r->latest;
+    samples = r->samples;
+    r->samples = 0;
+    pthread_mutex_unlock(&r->lock);
+
+    *val = sample.val;
+    if (samples) {
+        bench_record(BENCH_STAGE_SAMPLE, bench_now_ns() - sample.ts);
+    }
+
+    return 0;
+}
+
+static int replay_get_data(struct replay_hw *r, void *data) {
+    sensor_data_ival_t *val = (sensor_data_ival_t *) data;
+    struct replay_sample sample;
+    struct pollfd pfd;
+    int err;
+
+    pfd.fd = r->fds[0];
+    pfd.events = POLLIN;
+
+    while (1) {
+        err = read(r->fds[0], &sample, sizeof(sample));
+        if (err == (int) sizeof(sample)) {
+            break;
+        }
+        if (err < 0 && EAGAIN != errno && EINTR != errno) {
+            return -EIO;
+        }
+        poll(&pfd, 1, -1);
+    }
+
+    *val = sample.val;
+    bench_record(BENCH_STAGE_SAMPLE, bench_now_ns() - sample.ts);
+
+    return 0;
+}
+
+/* get_data callbacks carry no h/w pointer, so one pair per h/w type */
+#define REPLAY_GETTERS(t) \
+    static int replay_get_data_nb_##t(void *data) { \
+        return replay_get_data_nb(&g_replay[SENSOR_HW_TYPE_##t], data); \
+    } \
+    static int replay_get_data_##t(void *data) { \
+        return replay_get_data(&g_replay[SENSOR_HW_TYPE_##t], data); \
+    }
+
+REPLAY_GETTERS(A)
+REPLAY_GETTERS(G)
+REPLAY_GETTERS(M)
+
+static int replay_enable(struct sensor_hw *hw, int enable) {
+    __atomic_store_n(&g_replay[hw->type].enabled, enable, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static int replay_init(struct sensor_hw *hw) {
+    (void) hw;
+    return 0;
+}
+
+static int replay_load(struct replay_hw *r, const char *path) {
+    struct stat st;
+    size_t frames = 0;
+    size_t i;
+    ssize_t len;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    if (fstat(fd, &st) || st.st_size < (off_t) sizeof(struct input_event) ||
+            st.st_size > BENCH_TRACE_MAX_SIZE) {
+        close(fd);
+        return -EINVAL;
+    }
+
+    r->ev = (struct input_event *) malloc(st.st_size);
+    if (NULL == r->ev) {
+        close(fd);
+        return -ENOMEM;
+    }
+
+    len = read(fd, r->ev, st.st_size);
+    close(fd);
+    if (len != st.st_size) {
+        free(r->ev);
+        r->ev = NULL;
+        return -EIO;
+    }
+
+    r->num_ev = len / sizeof(struct input_event);
+
+    /* the replay paces itself on the EV_SYN timestamps */
+    for (i = 0; i < r->num_ev; i++) {
+        if (EV_SYN == r->ev[i].type) {
+            frames++;
+        }
+    }
+    if (frames < 2 || replay_ev_time_us(&r->ev[r->num_ev - 1]) <=
+            replay_ev_time_us(&r->ev[0])) {
+        free(r->ev);
+        r->ev = NULL;
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+int bench_replay_attach(struct sensor_hw *hw) {
+    struct replay_hw *r;
+    char path[128];
+    pthread_t tid;
+    int err;
+
+    if (hw->type < 0 || hw->type >= SENSOR_HW_TYPE_MAX) {
+        return -EINVAL;
+    }
+
+    r = &g_replay[hw->type];
+    snprintf(path, sizeof(path), "%s/%s.ev", BENCH_REPLAY_DIR, hw->name);
+    err = replay_load(r, path);
+    if (err) {
+        PINFO("no replay trace for %s: %d", hw->name, err);
+        return err;
+    }
+
+    if (pipe(r->fds)) {
+        err = -errno;
+        free(r->ev);
+        r->ev = NULL;
+        return err;
+    }
+    fcntl(r->fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(r->fds[1], F_SETFL, O_NONBLOCK);
+
+    r->hw = hw;
+    pthread_mutex_init(&r->lock, NULL);
+
+    hw->init = replay_init;
+    hw->enable = replay_enable;
+    hw->restore_cfg = NULL;
+    hw->set_delay = NULL;
+    hw->fd_pollable = 1;
+    hw->fd_poll = r->fds[0];
+
+    switch (hw->type) {
+    case SENSOR_HW_TYPE_A:
+        hw->get_data_nb = replay_get_data_nb_A;
+        hw->get_data = replay_get_data_A;
+        break;
+    case SENSOR_HW_TYPE_G:
+        hw->get_data_nb = replay_get_data_nb_G;
+        hw->get_data = replay_get_data_G;
+        break;
+    case SENSOR_HW_TYPE_M:
+        hw->get_data_nb = replay_get_data_nb_M;
+        hw->get_data = replay_get_data_M;
+        break;
+    }
+
+    err = pthread_create(&tid, NULL, replay_proc, r);
+    if (err) {
+        PERR("error creating replay thread for %s: %d", hw->name, err);
+        return -err;
+    }
+    pthread_detach(tid);
+
+    PWARN("%s replayed from %s, %u events", hw->name, path,
+          (uint32_t) r->num_ev);
+
+    return 0;
+}
+
+void bench_init(void) {
+    pthread_t tid;
+
+    g_speed = property_get_int32("sensord.bench.speed", 100);
+    if (g_speed <= 0) {
+        g_speed = 100;
+    }
+
+    if (!pthread_create(&tid, NULL, bench_report_proc, NULL)) {
+        pthread_detach(tid);
+    }
+}
+
+#endif
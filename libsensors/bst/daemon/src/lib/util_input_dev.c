@@ -95,33 +95,14 @@
 #define LOG_TAG_MODULE "<util_input_dev>"
 
 #include "sensord.h"
+#include "input_registry.h"
 
 int input_get_event_num(const char *pname) {
+    struct input_dev_info info;
     int num = -1;
-    int i;
-    char filename[64];
-    int err;
-    char ev_name[64];
-    int fd;
 
-    for (i = 0; i < MAX_INPUT_DEV_NUM; i++) {
-        sprintf(filename, "/dev/input/event%d", i);
-        fd = open(filename, O_RDONLY);
-        if (fd >= 0) {
-            err = ioctl(fd, EVIOCGNAME(sizeof(ev_name) - 1), &ev_name);
-            PINFO("err: %d ev_name: %s", err, ev_name);
-            if (err < 1) {
-                ev_name[0] = '\0';
-            }
-
-            if (0 == strcmp(ev_name, pname)) {
-                num = i;
-                close(fd);
-                break;
-            }
-
-            close(fd);
-        }
+    if (!input_registry_find(pname, 0, &info)) {
+        num = info.event_num;
     }
 
     if (-1 == num) {
@@ -336,4 +336,54 @@ int get_num_set_bits_u32(uint32_t n) {
     }
 
     return ret;
-}
\ No newline at end of file
+}
+
+static uint32_t g_crc32_table[256];
+static pthread_once_t g_crc32_once = PTHREAD_ONCE_INIT;
+
+static void util_crc32_init() {
+    uint32_t c;
+    int i;
+    int k;
+
+    for (i = 0; i < 256; i++) {
+        c = i;
+        for (k = 0; k < 8; k++) {
+            c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+        }
+        g_crc32_table[i] = c;
+    }
+}
+
+
+/* CRC-32 (IEEE 802.3), pass 0 as crc for the first block */
+uint32_t util_crc32(uint32_t crc, const void *buf, size_t len) {
+    const uint8_t *p = (const uint8_t *) buf;
+
+    pthread_once(&g_crc32_once, util_crc32_init);
+
+    crc = ~crc;
+    while (len--) {
+        crc = g_crc32_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+
+void util_hist_dump(const char *name, const struct util_hist *hist) {
+    uint32_t count = hist->count;
+
+    /* in case the logs are compiled out */
+    UNUSED_PARAM(name);
+
+    if (!count) {
+        PINFO("%s: no samples", name);
+        return;
+    }
+
+    PINFO("%s: n: %u avg: %uus p50: <%uus p99: <%uus max: %uus",
+          name, count, (uint32_t) (hist->total / count),
+          util_hist_percentile(hist, 50), util_hist_percentile(hist, 99),
+          hist->max);
+}
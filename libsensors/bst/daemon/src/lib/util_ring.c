@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "util_ring.h"
+
+int ring_init(struct spsc_ring *r, uint32_t slots, uint32_t slot_size) {
+    if (!slots || (slots & (slots - 1))) {
+        return -EINVAL;
+    }
+
+    r->buf = (uint8_t *) calloc(slots, slot_size);
+    if (NULL == r->buf) {
+        return -ENOMEM;
+    }
+
+    r->slot_size = slot_size;
+    r->mask = slots - 1;
+    r->head = 0;
+    r->tail = 0;
+
+    return 0;
+}
+
+void ring_destroy(struct spsc_ring *r) {
+    free(r->buf);
+    r->buf = NULL;
+}
+
+void *ring_produce_slot(struct spsc_ring *r) {
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+
+    if (r->head - tail > r->mask) {
+        return NULL;
+    }
+
+    return r->buf + (r->head & r->mask) * r->slot_size;
+}
+
+void ring_produce_commit(struct spsc_ring *r) {
+    __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+
+void *ring_consume_slot(struct spsc_ring *r) {
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+    if (head == r->tail) {
+        return NULL;
+    }
+
+    return r->buf + (r->tail & r->mask) * r->slot_size;
+}
+
+void ring_consume_commit(struct spsc_ring *r) {
+    __atomic_store_n(&r->tail, r->tail + 1, __ATOMIC_RELEASE);
+}
@@ -95,31 +95,15 @@
 #define LOG_TAG_MODULE "<util_sysfs>"
 
 #include "sensord.h"
+#include "input_registry.h"
 
 int sysfs_get_input_dev_num(const char *pname) {
+    struct input_dev_info info;
     int num = -1;
 
-    int fd = -1;
-    char sysfs_node_path[128] = "";
-    char dev_name[128] = "";            /* NOTE: limitation */
-    int i;
-    int len = strlen(pname);
-
-    for (i = 0; i < MAX_INPUT_DEV_NUM; i++) {
-        sprintf(sysfs_node_path, "%s/input%d/name",
-                SYSFS_PATH_INPUT_DEV, i);
-        fd = open(sysfs_node_path, O_RDONLY);
-        if (-1 != fd) {
-            read(fd, dev_name, sizeof(dev_name) - 1);
-            PDEBUG("dev name: %s len_dev_name: %d pname: %s len: %d",
-                   dev_name, strlen(dev_name), pname, len);
-            close(fd);
-
-            if (0 == strncmp(dev_name, pname, len)) {
-                num = i;
-                break;
-            }
-        }
+    /* the registry reads every inputN/name once instead of per lookup */
+    if (!input_registry_find(pname, INPUT_REGISTRY_PREFIX, &info)) {
+        num = info.input_num;
     }
 
     if (-1 == num) {
@@ -233,6 +233,15 @@ int main(int argc, char *argv[]) {
 
     sensor_cfg_init();
 
+    err = calib_store_init();
+    if (err) {
+        PWARN("calibration profiles will not be saved");
+    }
+
+#ifdef __DEBUG_PIPELINE_BENCH__
+    bench_init();
+#endif
+
     err = hw_cntl_init();
     if (err) {
         PWARN("fail to init hw");
@@ -245,6 +254,9 @@ int main(int argc, char *argv[]) {
         goto exit_clean;
     }
 
+    /* everything is resolved now, make the next start a fast one */
+    cfg_snapshot_commit();
+
     /* event handler register */
     err = ev_init();
     if (err) {
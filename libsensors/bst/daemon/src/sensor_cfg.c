@@ -318,5 +318,24 @@ static void set_cfg_axis() {
 
 
 void sensor_cfg_init() {
+    int32_t place[3];
+
+    cfg_snapshot_load();
+
+    if ((int) sizeof(place) == cfg_snapshot_get(CFG_SNAPSHOT_AXIS,
+                                                place, sizeof(place))) {
+        g_place_a = place[0];
+        g_place_m = place[1];
+        g_place_g = place[2];
+        PINFO("axis config from snapshot: %d %d %d",
+              g_place_a, g_place_m, g_place_g);
+        return;
+    }
+
     set_cfg_axis();
+
+    place[0] = g_place_a;
+    place[1] = g_place_m;
+    place[2] = g_place_g;
+    cfg_snapshot_put(CFG_SNAPSHOT_AXIS, place, sizeof(place));
 }
\ No newline at end of file
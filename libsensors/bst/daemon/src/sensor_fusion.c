@@ -219,6 +219,16 @@ void fusion_proc_data(uint32_t ts) {
 }
 
 
+int fusion_sample_data(uint32_t ts, void *frame) {
+    return algo_sample_data(ts, frame);
+}
+
+
+void fusion_fuse_data(void *frame) {
+    algo_fuse_data(frame);
+}
+
+
 void fusion_arbitrate_dr() {
     struct algo_product *ap;
     int i;
@@ -299,6 +309,16 @@ int fusion_on_hw_dep_checked(const hw_dep_set_t *dep) {
 }
 
 
+void fusion_hold_update(int hold) {
+    algo_hold_update(hold);
+}
+
+
+uint32_t fusion_get_changed() {
+    return algo_get_changed_products();
+}
+
+
 struct algo g_sp_algo_fusion = {
     .sp =
     {
@@ -328,11 +348,16 @@ struct algo g_sp_algo_fusion = {
         .ref = 0,
         .init = fusion_init,
         .proc_data = fusion_proc_data,
+        .sample_data = fusion_sample_data,
+        .fuse_data = fusion_fuse_data,
+        .frame_size = sizeof(libraryinput_t),
         .on_ch_enabled = fusion_on_ch_enabled,
         .on_ch_interval_changed = fusion_on_ch_interval_changed,
         .get_hint_proc_interval = fusion_get_hint_proc_interval,
         .get_curr_hw_dep = fusion_get_curr_hw_dep,
         .on_hw_dep_checked = fusion_on_hw_dep_checked,
+        .hold_update = fusion_hold_update,
+        .get_changed = fusion_get_changed,
         .exit = NULL,
         .re =
         {
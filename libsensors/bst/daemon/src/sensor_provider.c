@@ -84,6 +84,11 @@
  *
  */
 
+/* for the cpu_set_t macros and sched_setaffinity() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -91,6 +96,8 @@
 #include <stdio.h>
 #include <signal.h>
 #include <pthread.h>
+#include <sched.h>
+#include <string.h>
 #include <time.h>
 
 #include <linux/fs.h>
@@ -100,6 +107,9 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/syscall.h>
+#include <sys/prctl.h>
+
+#include <cutils/properties.h>
 
 
 #define LOG_TAG_MODULE "<sensor_provider>"
@@ -117,12 +127,101 @@ static const struct sensor_provider *g_list_sp[] = {
     NULL        /* the terminator */
 };
 
+/* frame header put in front of the provider data in each ring slot */
+struct sp_frame {
+    uint32_t ts;
+    int64_t ts_boot;
+};
+
+#define SP_FRAME_RING_SLOTS 16
+
 #ifdef __DEBUG_TIMING_ACCURACY__
 static unsigned int total_sleep_count = 0, over_sleep_count = 0;
 static unsigned int peek_sleep_duration = 0;
 #endif
 
 
+/*
+ * the scheduling of a provider is taken from the properties
+ * sensord.sched.<name>.{prio,fprio,cpus,slack}, e.g. to keep sampling
+ * on time while the foreground app saturates the big cores
+ */
+static int32_t sp_sched_prop(const struct sensor_provider *sp,
+                             const char *key, int32_t def) {
+    char name[PROPERTY_KEY_MAX];
+    char value[PROPERTY_VALUE_MAX];
+    char *end;
+    long v;
+
+    snprintf(name, sizeof(name), "sensord.sched.%s.%s", sp->name, key);
+    if (property_get(name, value, NULL) <= 0) {
+        return def;
+    }
+
+    /* cpus is usually given in hex */
+    v = strtol(value, &end, 0);
+    if ((end == value) || ('\0' != *end)) {
+        PWARN("invalid %s: %s", name, value);
+        return def;
+    }
+
+    return (int32_t) v;
+}
+
+
+static void sp_load_sched(struct sensor_provider *sp) {
+    struct sp_sched *sched = &sp->sched;
+
+    sched->prio = sp_sched_prop(sp, "prio", sched->prio);
+    sched->prio_fuse = sp_sched_prop(sp, "fprio", sched->prio_fuse);
+    sched->cpus = (uint32_t) sp_sched_prop(sp, "cpus", sched->cpus);
+    sched->slack = sp_sched_prop(sp, "slack", sched->slack);
+
+    PINFO("%s sched: prio: %d fprio: %d cpus: 0x%x slack: %dus",
+          sp->name, sched->prio, sched->prio_fuse,
+          sched->cpus, sched->slack);
+}
+
+
+/* applied by each thread to itself */
+static void sp_apply_sched(const struct sensor_provider *sp, int prio) {
+    const struct sp_sched *sched = &sp->sched;
+    struct sched_param param;
+    cpu_set_t set;
+    int i;
+
+    if (prio > 0) {
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = prio;
+        if (sched_setscheduler(0, SCHED_FIFO, &param)) {
+            PWARN("%s: error setting SCHED_FIFO %d: %d",
+                  sp->name, prio, errno);
+        }
+    }
+
+    if (sched->cpus) {
+        CPU_ZERO(&set);
+        for (i = 0; i < 32; i++) {
+            if (sched->cpus & (1u << i)) {
+                CPU_SET(i, &set);
+            }
+        }
+
+        if (sched_setaffinity(0, sizeof(set), &set)) {
+            PWARN("%s: error setting affinity 0x%x: %d",
+                  sp->name, sched->cpus, errno);
+        }
+    }
+
+    if (sched->slack > 0) {
+        if (prctl(PR_SET_TIMERSLACK,
+                  (unsigned long) sched->slack * 1000, 0, 0, 0)) {
+            PWARN("%s: error setting timer slack: %d", sp->name, errno);
+        }
+    }
+}
+
+
 void sp_preinit() {
     int i = 0;
     struct run_entity *re;
@@ -136,6 +235,7 @@ void sp_preinit() {
             sp->ref = 0;
 
             sp->curr_hw_dep = 0;
+            sp->held = 0;
             sp->clients = NULL;
             sp->buf_out = NULL;
 
@@ -151,6 +251,13 @@ void sp_preinit() {
 
             pthread_cond_init(&re->cond, NULL);
 
+            sp->fe.ptid = -1;
+            sp->fe.tid = -1;
+            sp->fe.started = 0;
+            sp->fe.dropped = 0;
+
+            sp_load_sched(sp);
+
             err = sp->init(sp);
             if (err) {
                 PWARN("error init of sensor provider: %s", sp->name);
@@ -175,12 +282,43 @@ static void sp_sync_re() {
             while (!sp->re.started) {
                 eusleep(1000);
             }
+
+            while ((-1 != (long) sp->fe.ptid) && !sp->fe.started) {
+                eusleep(1000);
+            }
         }
 
     PINFO("all available threads are ready now");
 }
 
 
+static void sp_init_fe(struct sensor_provider *sp) {
+    struct fuse_entity *fe = &sp->fe;
+    /* keep the frames 8 bytes aligned */
+    uint32_t slot_size = (sizeof(struct sp_frame) + sp->frame_size + 7) & ~7;
+    int err;
+
+    err = ring_init(&fe->ring, SP_FRAME_RING_SLOTS, slot_size);
+    if (err) {
+        PERR("no mem for frames of %s", sp->name);
+        return;
+    }
+
+    sem_init(&fe->frames, 0, 0);
+
+    err = pthread_create(&fe->ptid, NULL, re_fuse_proc, (void *) sp);
+    if (!err) {
+        PINFO("fuse thread created for provider: %s", sp->name);
+    } else {
+        /* run both stages on the provider thread as before */
+        PERR("error creating fuse thread for provider: %s", sp->name);
+        fe->ptid = -1;
+        sem_destroy(&fe->frames);
+        ring_destroy(&fe->ring);
+    }
+}
+
+
 void sp_init() {
     int err = 0;
     int i = 0;
@@ -222,6 +360,10 @@ void sp_init() {
                 data[tmp].data.version = sizeof(data[0]);
             }
 
+            if (NULL != sp->sample_data && NULL != sp->fuse_data) {
+                sp_init_fe(sp);
+            }
+
             err = pthread_create(&sp->re.ptid,
                                  NULL,
                                  sp->re.func,
@@ -337,58 +479,88 @@ void sp_recalc_interval_re(struct sensor_provider *sp) {
 }
 
 
-void sp_enable_ch(struct sensor_provider *sp, struct channel *ch, int enable) {
-        struct list_node *head;
-        int err;
+void sp_enable_ch_begin(struct sensor_provider *sp, struct channel *ch,
+                        int enable) {
+    struct list_node *head;
+    int err;
 
-        head = sp->clients;
+    head = sp->clients;
 
-        if (enable) {
-            if (NULL == list_find_node(head, &ch->client)) {
-                list_add_head(head, &ch->client);
-            }
-
-            sp->clients = &ch->client;
-        } else {
-            head = list_del_node(head, &ch->client);
-            sp->clients = head;
+    if (enable) {
+        if (NULL == list_find_node(head, &ch->client)) {
+            list_add_head(head, &ch->client);
         }
 
+        ch->ts_last_report = 0;
 
-        /* notice provider that some channel will be switched on/off */
-        /* provider should know that the h/w might not be switched on/off yet */
-        err = sp->on_ch_enabled(ch, enable);
-        if (err) {
-            PWARN("on_ch_enabled: %d error for %s", enable, ch->name);
-        }
+        sp->clients = &ch->client;
+    } else {
+        head = list_del_node(head, &ch->client);
+        sp->clients = head;
+    }
 
-        sp_re_check_dep_hw(sp);
 
-        if (NULL != sp->on_hw_dep_checked) {
-            sp->on_hw_dep_checked(&sp->curr_hw_dep);
-        }
+    /* notice provider that some channel will be switched on/off */
+    /* provider should know that the h/w might not be switched on/off yet */
+    err = sp->on_ch_enabled(ch, enable);
+    if (err) {
+        PWARN("on_ch_enabled: %d error for %s", enable, ch->name);
+    }
+}
 
-        sp_recalc_interval_re(sp);
 
-        if (ch->cfg.bypass_proc) {
-            /* no need to update the ref,
-             * thus return */
-            PDEBUG("sp act as hw manager only for: %s", ch->name);
-            return;
-        }
+void sp_hold_update(struct sensor_provider *sp) {
+    if ((NULL != sp->hold_update) && !sp->held) {
+        sp->hold_update(1);
+        sp->held = 1;
+    }
+}
 
-        if (enable) {
-            sp->ref += 1;
-            if (1 == sp->ref) {
-                /* CHECK: lock_cond is already locked */
-                pthread_cond_signal(&sp->re.cond);
-            }
-        } else {
-            if (sp->ref > 0) {
-                sp->ref -= 1;
-            }
+
+void sp_reconfigure(struct sensor_provider *sp) {
+    if (sp->held) {
+        sp->held = 0;
+        sp->hold_update(0);
+    }
+
+    sp_re_check_dep_hw(sp);
+
+    if (NULL != sp->on_hw_dep_checked) {
+        sp->on_hw_dep_checked(&sp->curr_hw_dep);
+    }
+
+    sp_recalc_interval_re(sp);
+}
+
+
+void sp_enable_ch_end(struct sensor_provider *sp, struct channel *ch,
+                      int enable) {
+    if (ch->cfg.bypass_proc) {
+        /* no need to update the ref,
+         * thus return */
+        PDEBUG("sp act as hw manager only for: %s", ch->name);
+        return;
+    }
+
+    if (enable) {
+        sp->ref += 1;
+        if (1 == sp->ref) {
+            /* CHECK: lock_cond is already locked */
+            pthread_cond_signal(&sp->re.cond);
+        }
+    } else {
+        if (sp->ref > 0) {
+            sp->ref -= 1;
         }
     }
+}
+
+
+void sp_enable_ch(struct sensor_provider *sp, struct channel *ch, int enable) {
+    sp_enable_ch_begin(sp, ch, enable);
+    sp_reconfigure(sp);
+    sp_enable_ch_end(sp, ch, enable);
+}
 
 
 static int sp_report_data(void *buf, int n) {
@@ -443,25 +615,134 @@ void sp_sleep(unsigned int delay) {
 #endif
 }
 
+static int64_t sp_get_boottime_ns(void) {
+    struct timespec tsnsec;
+
+    clock_gettime(CLOCK_BOOTTIME, &tsnsec);
+    return (int64_t)((tsnsec.tv_sec * TIME_SCALE_S2NS) + tsnsec.tv_nsec);
+}
+
+static void sp_record_interval(struct channel *ch, int64_t ts) {
+    int64_t dev;
+
+    if (ch->ts_last_report && !ch->cfg.no_delay) {
+        dev = (ts - ch->ts_last_report) / 1000
+              - (int64_t) ch->interval * 1000;
+        util_hist_add(&ch->stat_jitter, (uint32_t) ABS(dev));
+    }
+
+    ch->ts_last_report = ts;
+}
+
+/*
+ * collect the data of the channels due at time_start,
+ * stamped with ts_boot, or with the current time if it is 0
+ */
+static int sp_collect_data(struct sensor_provider *sp, struct exchange *data,
+                           unsigned int time_start, int64_t ts_boot) {
+    struct list_node *cur = NULL;
+    struct channel *ch = NULL;
+    unsigned int elapse = 0;
+    uint32_t changed = 0;
+    int num = 0;
+    int ret = 0;
+
+    if (NULL != sp->get_changed) {
+        changed = sp->get_changed();
+    }
+
+    cur = sp->clients;
+    while (NULL != cur) {
+        ch = CONTAINER_OF(cur,
+                          struct channel, client);
+
+        if (ch->cfg.on_change) {
+            if ((CHANNEL_STATE_NORMAL == ch->state)
+                    && (changed & (1 << ch->type))
+                    && (ch->get_data(data + num, sp->client_num - num) > 0)) {
+                data[num].data.sensor = ch->handle;
+                data[num].data.type = ch->type;
+                data[num].ts = ts_boot ? ts_boot : sp_get_boottime_ns();
+                num++;
+                ch->ts_last_ev = time_start;
+            }
+        } else if ((CHANNEL_STATE_NORMAL == ch->state)
+                && !ch->cfg.bypass_proc) {
+
+            /* elapse value is at least one frame, hence no possibility of
+               less than 5ms */
+            elapse = time_start - ch->ts_last_ev;
+
+            /* no delay is for event type sensor, which need to report
+               immediately after data update. */
+            if (ch->cfg.no_delay ||
+                    (elapse >= (uint32_t) ch->interval * 1000)) {
+                ret = ch->get_data(data + num, sp->client_num - num);
+                if (ret > 0) {
+                    data[num].data.sensor = ch->handle;
+                    data[num].data.type = ch->type;
+                    data[num].ts = ts_boot ? ts_boot : sp_get_boottime_ns();
+                    sp_record_interval(ch, data[num].ts);
+                    num++;
+                }
+                ch->ts_last_ev = time_start;
+            }
+        }
+
+        cur = cur->next;
+    }
+
+    return num;
+}
+
+static void sp_sample_frame(struct sensor_provider *sp, uint32_t ts,
+                            unsigned int time_start) {
+    struct fuse_entity *fe = &sp->fe;
+    struct sp_frame *frame;
+
+    frame = (struct sp_frame *) ring_produce_slot(&fe->ring);
+    if (NULL == frame) {
+        /* the fusion stage is behind, keep the sampling cadence */
+        if (!(fe->dropped++ % 100)) {
+            PWARN("%s: fusion behind, %u frames dropped",
+                  sp->name, fe->dropped);
+        }
+        return;
+    }
+
+    frame->ts = time_start;
+    frame->ts_boot = sp_get_boottime_ns();
+    if (sp->sample_data(ts, frame + 1)) {
+        return;
+    }
+
+    ring_produce_commit(&fe->ring);
+    sem_post(&fe->frames);
+}
+
 void *re_proc(void *pparam) {
     int sleep_time = 0;
     struct run_entity *re = NULL;
     struct sensor_provider *sp = NULL;
-    struct channel *ch = NULL;
-    struct list_node *cur = NULL;
     struct exchange *data = NULL;
     unsigned int time_start = 0;
     unsigned int time_now = 0;
+    /* when the thread should wake up, 0 if it was not sleeping */
+    unsigned int time_due = 0;
     unsigned int elapse = 0;
     int num = 0;
     int ret = 0;
 #ifdef __SCHEDULING_TIMESTAMP_CALIBRATED__
     unsigned int cali_timestamp = 0;
 #endif
+#ifdef __DEBUG_PIPELINE_BENCH__
+    uint64_t bench_ts = 0;
+#endif
 
     sp = (struct sensor_provider *) pparam;
     re = &sp->re;
     re->tid = (int) syscall(__NR_gettid);
+    sp_apply_sched(sp, sp->sched.prio);
     re->started = 1;
 
     data = (struct exchange *) sp->buf_out;
@@ -478,6 +759,7 @@ void *re_proc(void *pparam) {
 #ifdef __SCHEDULING_TIMESTAMP_CALIBRATED__
             cali_timestamp = 0;
 #endif
+            time_due = 0;
             /* wait for the sensor to be restarted */
             pthread_mutex_lock(&sp->lock_ref);
             ret = pthread_cond_wait(&re->cond,
@@ -491,59 +773,59 @@ void *re_proc(void *pparam) {
 
         /* start to proc sensor signal */
         time_start = get_current_timestamp();
-        if (NULL != sp->proc_data) {
+        if (time_due) {
+            util_hist_add(&re->stat_wakeup,
+                          (int) (time_start - time_due) > 0 ?
+                          time_start - time_due : 0);
+            time_due = 0;
+        }
+#ifdef __DEBUG_PIPELINE_BENCH__
+        bench_wakeup();
+        bench_ts = bench_now_ns();
+#endif
+        if (sp->fe.started) {
+            /* pipelined: the fuse entity does the rest */
 #ifdef __SCHEDULING_TIMESTAMP_CALIBRATED__
-            sp->proc_data(cali_timestamp);
+            sp_sample_frame(sp, cali_timestamp, time_start);
             cali_timestamp += re->interval * 1000;
 #else
-            sp->proc_data(time_start);
+            sp_sample_frame(sp, time_start, time_start);
+#endif
+        } else {
+            if (NULL != sp->proc_data) {
+#ifdef __SCHEDULING_TIMESTAMP_CALIBRATED__
+                sp->proc_data(cali_timestamp);
+                cali_timestamp += re->interval * 1000;
+#else
+                sp->proc_data(time_start);
+#endif
+#ifdef __DEBUG_PIPELINE_BENCH__
+                bench_record(BENCH_STAGE_PROC, bench_now_ns() - bench_ts);
+                bench_ts = bench_now_ns();
 #endif
-        }
-
-        cur = sp->clients;
-        num = 0;
-        while (NULL != cur) {
-            ch = CONTAINER_OF(cur,
-                              struct channel, client);
-
-            if ((CHANNEL_STATE_NORMAL == ch->state)
-                    && !ch->cfg.bypass_proc) {
-
-                /* elapse value is at least one frame, hence no possibility of
-                   less than 5ms */
-                elapse = time_start - ch->ts_last_ev;
-
-                /* no delay is for event type sensor, which need to report
-                   immediately after data update. */
-                if (ch->cfg.no_delay ||
-                        (elapse >= (uint32_t) ch->interval * 1000)) {
-                    ret = ch->get_data(data + num, sp->client_num - num);
-                    if (ret > 0) {
-                        struct timespec tsnsec;
-                        clock_gettime(CLOCK_BOOTTIME, &tsnsec);
-                        data[num].data.sensor = ch->handle;
-                        data[num].data.type = ch->type;
-                        data[num].ts = (int64_t)((tsnsec.tv_sec * TIME_SCALE_S2NS) + tsnsec.tv_nsec);
-                        num++;
-                    }
-                    ch->ts_last_ev = time_start;
-                }
             }
 
-            cur = cur->next;
+            num = sp_collect_data(sp, data, time_start, 0);
+            sp_report_data(data, num);
+#ifdef __DEBUG_PIPELINE_BENCH__
+            if (num > 0) {
+                bench_record(BENCH_STAGE_REPORT, bench_now_ns() - bench_ts);
+            }
+#endif
         }
 
-        sp_report_data(data, num);
-
         /* caculate sleep duration */
         time_now = get_current_timestamp();
         elapse = time_now - time_start;
+        util_hist_add(&re->stat_proc, elapse);
         if (elapse >= re->interval * 1000) {
+            re->overruns++;
             continue;
         }
 
         sleep_time = re->interval * 1000 - elapse;
         if (sleep_time > 200) {
+            time_due = time_now + sleep_time;
             sp_sleep(sleep_time);
         }
 
@@ -556,6 +838,62 @@ void *re_proc(void *pparam) {
 }
 
 
+void *re_fuse_proc(void *pparam) {
+    struct sensor_provider *sp = NULL;
+    struct fuse_entity *fe = NULL;
+    struct exchange *data = NULL;
+    struct sp_frame *frame;
+    unsigned int time_start;
+    int num = 0;
+#ifdef __DEBUG_PIPELINE_BENCH__
+    uint64_t bench_ts = 0;
+#endif
+
+    sp = (struct sensor_provider *) pparam;
+    fe = &sp->fe;
+    fe->tid = (int) syscall(__NR_gettid);
+    sp_apply_sched(sp, sp->sched.prio_fuse);
+    fe->started = 1;
+
+    data = (struct exchange *) sp->buf_out;
+    while (1) {
+        if (sem_wait(&fe->frames)) {
+            continue;
+        }
+
+        frame = (struct sp_frame *) ring_consume_slot(&fe->ring);
+        if (NULL == frame) {
+            continue;
+        }
+
+        time_start = get_current_timestamp();
+
+#ifdef __DEBUG_PIPELINE_BENCH__
+        bench_ts = bench_now_ns();
+#endif
+        sp->fuse_data(frame + 1);
+#ifdef __DEBUG_PIPELINE_BENCH__
+        bench_record(BENCH_STAGE_PROC, bench_now_ns() - bench_ts);
+        bench_ts = bench_now_ns();
+#endif
+
+        /* stamp the data with the time it was sampled, not fused */
+        num = sp_collect_data(sp, data, frame->ts, frame->ts_boot);
+        ring_consume_commit(&fe->ring);
+
+        sp_report_data(data, num);
+        util_hist_add(&fe->stat_proc, get_current_timestamp() - time_start);
+#ifdef __DEBUG_PIPELINE_BENCH__
+        if (num > 0) {
+            bench_record(BENCH_STAGE_REPORT, bench_now_ns() - bench_ts);
+        }
+#endif
+    }
+
+    return (pparam);
+}
+
+
 void sp_dump() {
     struct sensor_provider *sp;
     struct run_entity *re;
@@ -576,5 +914,16 @@ void sp_dump() {
             PINFO("client_num: %d", sp->client_num);
             PINFO("ref: %d", sp->ref);
             PINFO("interval: %d", re->interval);
+            PINFO("sched: prio: %d fprio: %d cpus: 0x%x slack: %dus",
+                  sp->sched.prio, sp->sched.prio_fuse,
+                  sp->sched.cpus, sp->sched.slack);
+            util_hist_dump("wakeup lateness", &re->stat_wakeup);
+            util_hist_dump("proc time", &re->stat_proc);
+            PINFO("overruns: %u", re->overruns);
+            if (sp->fe.started) {
+                PINFO("fuse tid: %d", sp->fe.tid);
+                PINFO("frames dropped: %u", sp->fe.dropped);
+                util_hist_dump("fuse time", &sp->fe.stat_proc);
+            }
         }
 }
\ No newline at end of file
@@ -49,9 +49,13 @@ LOCAL_SRC_FILES := \
     SensorBase.cpp \
     LightSensor.cpp \
     ProximitySensor.cpp \
-    BstSensorInfo.cpp
+    BstSensorInfo.cpp \
+    ../../common/input_registry.c \
+    ../../common/poll_engine.c \
+    ../../common/util_hist.c
 
-LOCAL_C_INCLUDES = $(LOCAL_PATH)/../version
+LOCAL_C_INCLUDES = $(LOCAL_PATH)/../version \
+    $(LOCAL_PATH)/../../common
 
 #LOCAL_SHARED_LIBRARIES := liblog libcutils
 LOCAL_SHARED_LIBRARIES := libcutils
@@ -70,7 +74,8 @@ LOCAL_SRC_FILES += BstSensorExt.cpp
 endif
 
 ifeq (true, $(hybrid_hal))
-LOCAL_SRC_FILES += BstSensorAccel.cpp
+LOCAL_SRC_FILES += BstSensorAccel.cpp \
+    ../../common/axis_conv.c
 endif
 
 include $(BUILD_SHARED_LIBRARY)
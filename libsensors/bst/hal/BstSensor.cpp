@@ -108,9 +108,38 @@
 #include "sensors.h"
 
 #include "TargetPlatform.h"
+#include "util_hist.h"
 
 #define GET_HANDLES_TRY_NUM         20
 
+#ifdef __DEBUG_PIPELINE_BENCH__
+#define BENCH_REPORT_EVENTS         2000
+
+/* daemon timestamp -> HAL read latency */
+static struct util_hist s_bench_fifo;
+
+static void bench_record_fifo(int64_t ts) {
+    struct timespec now;
+    struct util_hist snap;
+    int64_t delta;
+
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    delta = (int64_t) now.tv_sec * 1000000000LL + now.tv_nsec - ts;
+    util_hist_add(&s_bench_fifo, delta > 0 ? (uint32_t)(delta / 1000) : 0);
+
+    if (s_bench_fifo.count < BENCH_REPORT_EVENTS) {
+        return;
+    }
+
+    util_hist_take(&s_bench_fifo, &snap);
+    PINFO("<BST> " "[bench] fifo n: %u avg: %uus p50: <%uus p90: <%uus "
+          "p99: <%uus max: %uus", snap.count,
+          (uint32_t)(snap.total / snap.count),
+          util_hist_percentile(&snap, 50), util_hist_percentile(&snap, 90),
+          util_hist_percentile(&snap, 99), snap.max);
+}
+#endif
+
 const int BstSensor::s_tab_id2handle[BST_SENSOR_NUM_MAX] = {
     BST_SENSOR_HANDLE_ACCELERATION,             /* 0 */
 #ifdef __USECASE_TYPE_ACCEL_ONLY__
@@ -271,12 +300,27 @@ int BstSensor::initIPC() {
 
 BstSensor::BstSensor()
 : SensorBase(NULL, NULL),
-mEnabled(0) {
+mEnabled(0),
+mPendingMask(0),
+mCtrlSeq(0),
+mCtrlExit(false),
+mCtrlStarted(false) {
     struct exchange cmd;
     int i = 0;
     int ret = 0;
     int fData = -1;
 
+    /* no batch sent yet */
+    memset(mSentSeq, 0xff, sizeof(mSentSeq));
+    pthread_mutex_init(&mCtrlLock, NULL);
+    pthread_cond_init(&mCtrlCond, NULL);
+    ret = pthread_create(&mCtrlThread, NULL, ctrlThread, this);
+    if (ret) {
+        LOGE("<BST> " "error creating ctrl thread: %d", ret);
+    } else {
+        mCtrlStarted = true;
+    }
+
     do {
         if (i++ > GET_HANDLES_TRY_NUM) {
             LOGE("initIPC failed:%d", ret);
@@ -318,6 +362,16 @@ mEnabled(0) {
 }
 
 BstSensor::~BstSensor() {
+    if (mCtrlStarted) {
+        pthread_mutex_lock(&mCtrlLock);
+        mCtrlExit = true;
+        pthread_cond_signal(&mCtrlCond);
+        pthread_mutex_unlock(&mCtrlLock);
+        pthread_join(mCtrlThread, NULL);
+    }
+    pthread_cond_destroy(&mCtrlCond);
+    pthread_mutex_destroy(&mCtrlLock);
+
     /* mCmdFd is added by BstSensor, while
      * data_fd is added by SensorBase
      * so here, only close mCmdFd */
@@ -347,10 +401,175 @@ int BstSensor::handle2id(int32_t handle) {
 }
 
 
+int BstSensor::queueCtrl(int handle, int flags, int active,
+                         int interval, int latency) {
+    struct ctrl_entry *e;
+    bool first;
+
+    if ((handle < 1) || (handle > BST_SENSOR_NUM_MAX)) {
+        return -EINVAL;
+    }
+
+    if (mCmdFd < 0) {
+        LOGE("<BST> " "cannot tx cmd: %s",
+             (char *) strerror(-mCmdFd));
+        return mCmdFd;
+    }
+
+    if (!mCtrlStarted) {
+        return -EIO;
+    }
+
+    pthread_mutex_lock(&mCtrlLock);
+    e = &mPending[handle - 1];
+    if (!(mPendingMask & (1 << (handle - 1)))) {
+        memset(e, 0, sizeof(*e));
+        e->handle = handle;
+    }
+
+    /* a later command to the same sensor overrides the earlier one */
+    e->flags |= flags;
+    if (flags & CTRL_F_ACTIVE) {
+        e->active = active;
+    }
+    if (flags & CTRL_F_DELAY) {
+        e->interval = interval;
+        e->latency = latency;
+    }
+
+    first = !mPendingMask;
+    mPendingMask |= (1 << (handle - 1));
+    if (first) {
+        pthread_cond_signal(&mCtrlCond);
+    }
+    pthread_mutex_unlock(&mCtrlLock);
+
+    return 0;
+}
+
+
+void BstSensor::sendCtrlBatch(const struct ctrl_entry *entries, int num,
+                              int32_t seq) {
+    struct {
+        struct exchange hdr;
+        struct ctrl_entry entries[CTRL_BATCH_MAX];
+    } batch;
+    int size;
+    int err;
+
+    memset(&batch.hdr, 0, sizeof(batch.hdr));
+    batch.hdr.magic = CHANNEL_PKT_MAGIC_BATCH;
+    batch.hdr.command.cmd = CTRL_PROTO_VERSION;
+    batch.hdr.command.code = seq;
+    batch.hdr.command.value = num;
+    batch.hdr.command.reserved[0] = sizeof(struct ctrl_entry);
+    memcpy(batch.entries, entries, num * sizeof(struct ctrl_entry));
+
+    /* below PIPE_BUF, so the daemon never sees a partial batch */
+    size = sizeof(batch.hdr) + num * sizeof(struct ctrl_entry);
+    err = write(mCmdFd, &batch, size);
+    if (err < size) {
+        LOGE("<BST> " "error sending cmd batch %d: %d",
+             batch.hdr.command.code, err < 0 ? -errno : err);
+    }
+}
+
+
+void *BstSensor::ctrlThread(void *arg) {
+    BstSensor *self = (BstSensor *) arg;
+    struct ctrl_entry entries[CTRL_BATCH_MAX];
+    int32_t seq;
+    int num;
+    int i;
+
+    pthread_mutex_lock(&self->mCtrlLock);
+    while (!self->mCtrlExit) {
+        if (!self->mPendingMask) {
+            pthread_cond_wait(&self->mCtrlCond, &self->mCtrlLock);
+            continue;
+        }
+
+        /* the framework reconfigures sensors one call at a time,
+         * give the calls that belong together a chance to arrive */
+        pthread_mutex_unlock(&self->mCtrlLock);
+        usleep(BST_CTRL_COALESCE_US);
+        pthread_mutex_lock(&self->mCtrlLock);
+
+        num = 0;
+        seq = self->mCtrlSeq++;
+        for (i = 0; i < BST_SENSOR_NUM_MAX && num < CTRL_BATCH_MAX; i++) {
+            if (self->mPendingMask & (1 << i)) {
+                entries[num++] = self->mPending[i];
+                self->mPendingMask &= ~(1 << i);
+                self->mSentSeq[i] = seq;
+            }
+        }
+
+        pthread_mutex_unlock(&self->mCtrlLock);
+        self->sendCtrlBatch(entries, num, seq);
+        pthread_mutex_lock(&self->mCtrlLock);
+    }
+    pthread_mutex_unlock(&self->mCtrlLock);
+
+    return NULL;
+}
+
+
+void BstSensor::readCtrlAck(const struct exchange *hdr) {
+    struct ctrl_result results[CTRL_BATCH_MAX];
+    const struct sensor_t *s;
+    int num = hdr->command.value;
+    int size;
+    int id;
+    int i;
+
+    if (hdr->command.reserved[0]) {
+        LOGE("<BST> " "cmd batch %d rejected: %d",
+             hdr->command.code, hdr->command.reserved[0]);
+    }
+
+    if ((num <= 0) || (num > CTRL_BATCH_MAX)) {
+        return;
+    }
+
+    size = num * sizeof(struct ctrl_result);
+    if (read(data_fd, results, size) < size) {
+        LOGE("<BST> " "bad condition, stream needs sync");
+        return;
+    }
+
+    for (i = 0; i < num; i++) {
+        id = BstSensor::handle2id(results[i].handle);
+        if (-1 == id) {
+            continue;
+        }
+
+        s = BstSensorInfo::getSensor(id);
+        if (results[i].err) {
+            LOGE("<BST> " "cmd to <%s> failed: %d",
+                 (s != NULL) ? s->name : "unknown", results[i].err);
+            continue;
+        }
+
+        /* what the daemon actually runs at, after clamping, unless a
+         * newer command to the sensor is queued or on its way */
+        pthread_mutex_lock(&mCtrlLock);
+        if (!(mPendingMask & (1 << (results[i].handle - 1))) &&
+                (mSentSeq[results[i].handle - 1] == hdr->command.code)) {
+            mDelays[id - ID_SENSOR_BASE_BST] = results[i].interval;
+        }
+        pthread_mutex_unlock(&mCtrlLock);
+        LOGI("<BST> " "<%s> %s at %dms",
+             (s != NULL) ? s->name : "unknown",
+             results[i].active ? "active" : "inactive",
+             results[i].interval);
+    }
+}
+
+
 int BstSensor::enable(int32_t id, int enable) {
     int err = 0;
     int handle;
-    struct exchange cmd;
     int pos = (int) id;
 
     const struct sensor_t *s;
@@ -360,12 +579,6 @@ int BstSensor::enable(int32_t id, int enable) {
         return -EINVAL;
     }
 
-    if (mCmdFd < 0) {
-        LOGE("<BST> " "cannot tx cmd: %s",
-             (char *) strerror(-mCmdFd));
-        return mCmdFd;
-    }
-
     enable = !!enable;
 
 
@@ -374,13 +587,7 @@ int BstSensor::enable(int32_t id, int enable) {
          enable ? "enable" : "disable",
          (s != NULL) ? s->name : "unknown");
 
-    cmd.magic = CHANNEL_PKT_MAGIC_CMD;
-    cmd.command.cmd = SET_SENSOR_ACTIVE;
-    cmd.command.code = handle;
-    cmd.command.value = enable;
-    cmd.ts = 0;
-    err = write(mCmdFd, &cmd, sizeof(cmd));
-    err = err < (int) sizeof(cmd) ? -1 : 0;
+    err = queueCtrl(handle, CTRL_F_ACTIVE, enable, 0, 0);
 
     if (!err) {
         if (enable) {
@@ -397,7 +604,6 @@ int BstSensor::enable(int32_t id, int enable) {
 int BstSensor::setDelay(int32_t id, int64_t ns) {
     int err = 0;
     int handle;
-    struct exchange cmd;
     const struct sensor_t *s;
 
     handle = BstSensor::id2handle(id);
@@ -405,29 +611,17 @@ int BstSensor::setDelay(int32_t id, int64_t ns) {
         return -EINVAL;
     }
 
-    if (mCmdFd < 0) {
-        LOGE("<BST> " "cannot tx cmd: %s",
-             (char *) strerror(-mCmdFd));
-        return mCmdFd;
-    }
-
-    cmd.magic = CHANNEL_PKT_MAGIC_CMD;
-
-    cmd.command.cmd = SET_SENSOR_DELAY;
-    cmd.command.code = handle;
-    cmd.command.value = ns / SCALE_TIME_MS2NS;
-    cmd.ts = 0;
-
     s = BstSensorInfo::getSensor(id);
     LOGI("<BST> " "set delay of <%s> to %jdms",
          (s != NULL) ? s->name : "unknown",
          ns / SCALE_TIME_MS2NS);
 
-    err = write(mCmdFd, &cmd, sizeof(cmd));
-    err = err < (int) sizeof(cmd) ? -1 : 0;
+    err = queueCtrl(handle, CTRL_F_DELAY, 0, ns / SCALE_TIME_MS2NS, 0);
 
     if (!err) {
+        pthread_mutex_lock(&mCtrlLock);
         mDelays[id - ID_SENSOR_BASE_BST] = ns / SCALE_TIME_MS2NS;
+        pthread_mutex_unlock(&mCtrlLock);
     }
 
     return err;
@@ -464,11 +658,20 @@ int BstSensor::readEvents(sensors_event_t *pdata, int count) {
             return rslt;
         }
 
+        if (CHANNEL_PKT_MAGIC_ACK == sensor_data.magic) {
+            readCtrlAck(&sensor_data);
+            return rslt;
+        }
+
         if (CHANNEL_PKT_MAGIC_DAT != sensor_data.magic) {
             LOGE("<BST> " "discard invalid data packet from stream");
             return rslt;
         }
 
+#ifdef __DEBUG_PIPELINE_BENCH__
+        bench_record_fifo(sensor_data.ts);
+#endif
+
 #if __HAL_VER__ >= __SENSORS_DEVICE_API_VERSION_1_1__
         if (SENSOR_TYPE_META_DATA == sensor_data.data.type) {
             sensor = sensor_data.data.sensor;
@@ -661,39 +864,45 @@ int BstSensor::getSensorList(struct sensor_t *list, int len) {
 #if __HAL_VER__ >= __SENSORS_DEVICE_API_VERSION_1_1__
 
 int BstSensor::flush(int id) {
-    int err = 0;
-    int ret = 0;
-    struct exchange cmd;
     const struct sensor_t *s;
     int handle;
-    if (mCmdFd < 0) {
-        PERR("<BST> " "cannot tx cmd: %s",
-             (char *) strerror(-mCmdFd));
-        return mCmdFd;
-    }
     handle = BstSensor::id2handle(id);
     if (-1 == handle) {
         PERR("<BST> " "flush: cannot get handle for id %d", id);
         return 0;
     }
-    cmd.magic = CHANNEL_PKT_MAGIC_CMD;
-    cmd.command.cmd = SET_SENSOR_FLUSH;
-    cmd.command.code = handle;
     s = BstSensorInfo::getSensor(id);
     PINFO("<BST> " "flush <%s>, id: %d",
           (s != NULL) ? s->name : "unknown", id);
-    err = write(mCmdFd, &cmd, sizeof(cmd));
-    ret = err < (int) sizeof(cmd) ? -1 : 0;
-    return ret;
+    /* sent after any activation queued with it, as the framework expects */
+    return queueCtrl(handle, CTRL_F_FLUSH, 0, 0, 0);
 }
 
 int BstSensor::batch(int id, int flags, int64_t period_ns, int64_t timeout) {
-    int ret = 0;
+    int err;
+    int handle;
+    const struct sensor_t *s;
 
     UNUSED_PARAM(flags);
-    UNUSED_PARAM(timeout);
-    ret = BstSensor::setDelay(id, period_ns);
-    return ret;
+    handle = BstSensor::id2handle(id);
+    if (-1 == handle) {
+        return -EINVAL;
+    }
+
+    s = BstSensorInfo::getSensor(id);
+    LOGI("<BST> " "batch <%s> at %jdms, latency: %jdms",
+         (s != NULL) ? s->name : "unknown",
+         period_ns / SCALE_TIME_MS2NS, timeout / SCALE_TIME_MS2NS);
+
+    err = queueCtrl(handle, CTRL_F_DELAY, 0, period_ns / SCALE_TIME_MS2NS,
+                    timeout / SCALE_TIME_MS2NS);
+    if (!err) {
+        pthread_mutex_lock(&mCtrlLock);
+        mDelays[id - ID_SENSOR_BASE_BST] = period_ns / SCALE_TIME_MS2NS;
+        pthread_mutex_unlock(&mCtrlLock);
+    }
+
+    return err;
 }
 
 #endif
\ No newline at end of file
@@ -91,6 +91,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
 #include <sys/cdefs.h>
 #include <sys/types.h>
 
@@ -102,6 +103,8 @@
 #include "BstSensorType.h"
 
 #define BST_DATA_POLL_TIMEOUT 500000
+/* commands issued within this window go to the daemon in one batch */
+#define BST_CTRL_COALESCE_US 2000
 
 enum BST_SENSOR_HANDLE {
     BST_SENSOR_HANDLE_START = 0,
@@ -190,11 +193,35 @@ class BstSensor : public SensorBase {
 
     protected:
     uint32_t mEnabled;
+    /* under mCtrlLock, the acks update it from the poll thread */
     uint64_t mDelays[BST_SENSOR_NUM_MAX];
     int mCmdFd;
 
     void processEvent(int code, int value);
 
+    /* control entries not sent yet, indexed by handle - 1 */
+    struct ctrl_entry mPending[BST_SENSOR_NUM_MAX];
+    uint32_t mPendingMask;
+    int32_t mCtrlSeq;
+    /* batch that carried the latest command sent to each sensor, only its
+     * ack may update mDelays, indexed by handle - 1 */
+    int32_t mSentSeq[BST_SENSOR_NUM_MAX];
+    bool mCtrlExit;
+    bool mCtrlStarted;
+    pthread_t mCtrlThread;
+    pthread_mutex_t mCtrlLock;
+    pthread_cond_t mCtrlCond;
+
+    int queueCtrl(int handle, int flags, int active,
+                  int interval, int latency);
+
+    void sendCtrlBatch(const struct ctrl_entry *entries, int num,
+                       int32_t seq);
+
+    void readCtrlAck(const struct exchange *hdr);
+
+    static void *ctrlThread(void *arg);
+
     const static int s_tab_id2handle[BST_SENSOR_NUM_MAX];
     const static int s_tab_handle2id[BST_SENSOR_NUM_MAX];
 
@@ -87,6 +87,7 @@ mDelegate(delegate) {
     mPendingEvent.sensor = ID_A;
     mPendingEvent.type = SENSOR_TYPE_ACCELEROMETER;
     memset(mPendingEvent.data, 0, sizeof(mPendingEvent.data));
+    memset(mRaw, 0, sizeof(mRaw));
 
     if (data_fd) {
         memset(mInputSysfsPath, 0, sizeof(mInputSysfsPath));
@@ -127,6 +128,8 @@ mDelegate(delegate) {
             PERR("<BST> unknow chip_id %d", chip_id);
         }
     }
+
+    initAxisConv();
 }
 
 
@@ -204,16 +207,13 @@ int BstSensorAccel::processEvent(const input_event *event) {
 #endif
         switch (event->code) {
         case ABS_X:
-            mPendingEvent.acceleration.x =
-                value * mScale * SCALE_GRAVITY;
+            mRaw[0] = value;
             break;
         case ABS_Y:
-            mPendingEvent.acceleration.y =
-                value * mScale * SCALE_GRAVITY;
+            mRaw[1] = value;
             break;
         case ABS_Z:
-            mPendingEvent.acceleration.z =
-                value * mScale * SCALE_GRAVITY;
+            mRaw[2] = value;
             break;
         default:
             err = -EINVAL;
@@ -245,8 +245,9 @@ int BstSensorAccel::readEvents(sensors_event_t *data, int count) {
         if (EV_SYN == type) {
             mPendingEvent.timestamp = timevalToNano(event->time);
             if (mEnabled) {
+                axis_conv_s32_f32(&mConv, mRaw,
+                                  mPendingEvent.acceleration.v, 1, 3);
                 *data = mPendingEvent;
-                remapSensorData(data, mPlace);
                 data++;
                 count--;
                 numEventReceived++;
@@ -367,21 +368,24 @@ void BstSensorAccel::unlock() {
     }
 }
 
-void BstSensorAccel::remapSensorData(sensors_event_t *event,
-                                     const struct bst_axis_remap *remap) {
-
-    sensors_event_t tmp;
-    tmp.data[0] = event->data[remap->src_x] * remap->sign_x;
-    tmp.data[1] = event->data[remap->src_y] * remap->sign_y;
-    tmp.data[2] = event->data[remap->src_z] * remap->sign_z;
-
-    memcpy(event->data, tmp.data, sizeof(event->data[0]) * 3);
-}
-
-void BstSensorAccel::remapSensorData(sensors_event_t *event, int place) {
-    if ((0 < place) && (BST_DFT_AXIS_REMAP_TAB_SZ > place)) {
-        remapSensorData(event,
-                        BstSensorAccel::sTabAxisRemapDft + place);
+void BstSensorAccel::initAxisConv() {
+    float scale = mScale * SCALE_GRAVITY;
+    const float scales[3] = {scale, scale, scale};
+    const struct bst_axis_remap *remap;
+    int src[3];
+    int sign[3];
+
+    if ((0 < mPlace) && (BST_DFT_AXIS_REMAP_TAB_SZ > mPlace)) {
+        remap = sTabAxisRemapDft + mPlace;
+        src[0] = remap->src_x;
+        src[1] = remap->src_y;
+        src[2] = remap->src_z;
+        sign[0] = remap->sign_x;
+        sign[1] = remap->sign_y;
+        sign[2] = remap->sign_z;
+        axis_conv_init(&mConv, src, sign, scales);
+    } else {
+        axis_conv_init_scale(&mConv, scales);
     }
 }
 
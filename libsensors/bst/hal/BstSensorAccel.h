@@ -40,6 +40,7 @@
 #include "SensorBase.h"
 #include "InputEventReader.h"
 #include "BstSensorPriv.h"
+#include "axis_conv.h"
 
 struct input_event;
 
@@ -140,11 +141,12 @@ class BstSensorAccel : public SensorBase {
 
     int processEvent(const input_event *event);
 
-    /* TODO: those should be moved out to some generic base class */
-    static void remapSensorData(sensors_event_t *event,
-                                const struct bst_axis_remap *remap);
+    /* raw x/y/z of the pending event, converted on EV_SYN */
+    int32_t mRaw[3];
+    struct axis_conv mConv;
 
-    static void remapSensorData(sensors_event_t *event, int place);
+    /* fold mPlace and mScale into mConv */
+    void initAxisConv();
 
     static int getBWFromDelay(uint64_t delay_us);
 
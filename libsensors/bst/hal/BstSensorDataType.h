@@ -216,6 +216,39 @@ struct exchange {
 };
 
 
+/*
+ * A control batch is a struct exchange with magic CHANNEL_PKT_MAGIC_BATCH,
+ * command.cmd: CTRL_PROTO_VERSION, command.code: a sequence number,
+ * command.value: the number of entries and command.reserved[0]: the size
+ * of an entry, followed by the entries. All of them are applied as one
+ * reconfiguration.
+ *
+ * It is answered on the data fifo by a struct exchange with magic
+ * CHANNEL_PKT_MAGIC_ACK, the same version and sequence number,
+ * command.value: the number of results and command.reserved[0]: the error
+ * of the batch as a whole, followed by one result per entry.
+ */
+struct ctrl_entry {
+    int32_t handle;
+    /* CTRL_F_* */
+    int32_t flags;
+    int32_t active;
+    /* in ms */
+    int32_t interval;
+    /* max report latency in ms, no h/w fifo to use it yet */
+    int32_t latency;
+};
+
+
+struct ctrl_result {
+    int32_t handle;
+    int32_t err;
+    int32_t active;
+    /* the interval in effect, in ms */
+    int32_t interval;
+};
+
+
 typedef char BS_S8;
 typedef uint8_t BS_U8;
 typedef int16_t BS_S16;
@@ -111,6 +111,18 @@
 #define CHANNEL_PKT_MAGIC_DAT   (int)'D'
 #define CHANNEL_PKT_MAGIC_LIST  (int)'L'
 
+#define CHANNEL_PKT_MAGIC_BATCH (int)'B'
+#define CHANNEL_PKT_MAGIC_ACK   (int)'K'
+
+/* batched control protocol, see struct ctrl_entry */
+#define CTRL_PROTO_VERSION      1
+/* keeps a batch and its ack within PIPE_BUF, so they are never torn */
+#define CTRL_BATCH_MAX          32
+
+#define CTRL_F_ACTIVE           0x01
+#define CTRL_F_DELAY            0x02
+#define CTRL_F_FLUSH            0x04
+
 #ifdef __HYBRID_HAL__
 struct bst_axis_remap {
     int src_x : 3;
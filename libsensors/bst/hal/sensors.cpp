@@ -20,7 +20,6 @@
 #include <errno.h>
 #include <dirent.h>
 #include <math.h>
-#include <poll.h>
 #include <pthread.h>
 #include <stdlib.h>
 
@@ -30,6 +29,7 @@
 
 
 #include "sensors.h"
+#include "poll_engine.h"
 
 #include "BstSensor.h"
 #include "LightSensor.h"
@@ -63,11 +63,13 @@ enum {
 #endif
     bst,
     numSensorDrivers,
-    numFds,
 };
 
 #define DELAY_OUT_TIME 0x7FFFFFFF
 
+/* events a single driver may return per round before the others get a turn */
+#define DRIVER_EVENT_BUDGET 64
+
 /*****************************************************************************/
 
 /* The SENSORS Module */
@@ -245,12 +247,14 @@ struct sensors_poll_context_t {
 
     private:
 
-    static const size_t wake = numFds - 1;
-    static const char WAKE_MESSAGE = 'W';
-    struct pollfd mPollFds[numFds];
-    int mWritePipeFd;
+    struct poll_engine mPoll;
+    uint32_t mReady;
+    uint32_t mKick;
+    int mNextDriver;
     SensorBase *mSensors[numSensorDrivers];
 
+    void kick(int index);
+
     int handleToDriver(int handle) const {
         switch (handle) {
         case ID_A:
@@ -306,46 +310,23 @@ struct sensors_poll_context_t {
 
 /*****************************************************************************/
 
-sensors_poll_context_t::sensors_poll_context_t() {
+sensors_poll_context_t::sensors_poll_context_t()
+: mReady(0), mKick(0), mNextDriver(0) {
     unsigned char bst_sensor_num = 0;
 
     mSensors[light] = new LightSensor();
-    mPollFds[light].fd = mSensors[light]->getFd();
-    mPollFds[light].events = POLLIN;
-    mPollFds[light].revents = 0;
-
     mSensors[proximity] = new ProximitySensor();
-    mPollFds[proximity].fd = mSensors[proximity]->getFd();
-    mPollFds[proximity].events = POLLIN;
-    mPollFds[proximity].revents = 0;
-
 #ifdef __PRESSURE_SENSOR_SUPPORT__
     mSensors[pressure] = new PressureSensor("bmp");
-    mPollFds[pressure].fd = mSensors[pressure]->getFd();
-    mPollFds[pressure].events = POLLIN;
-    mPollFds[pressure].revents = 0;
 #endif
-
 #ifdef __BST_EXTEND_SENSOR_SUPPORT__
     mSensors[bst_ext] = new BstSensorExt();
-    mPollFds[bst_ext].fd = mSensors[bst_ext]->getFd();
-    mPollFds[bst_ext].events = POLLIN;
-    mPollFds[bst_ext].revents = 0;
 #endif
-
     mSensors[bst] = new BstSensor();
-    mPollFds[bst].fd = mSensors[bst]->getFd();
-    mPollFds[bst].events = POLLIN;
-    mPollFds[bst].revents = 0;
-
 #ifdef __HYBRID_HAL__
     mSensors[bst_acc] = new BstSensorAccel(DEV_NAME_A,NULL);
-    mPollFds[bst_acc].fd = mSensors[bst_acc]->getFd();
-    mPollFds[bst_acc].events = POLLIN;
-    mPollFds[bst_acc].revents = 0;
 #endif
 
-
 #ifdef __BST_EXTEND_SENSOR_SUPPORT__
     bst_sensor_num = ((BstSensorExt *)mSensors[bst_ext] )->getSensorList(sSensorList + LOCAL_SENSORS,
                      sizeof(sSensorList[0]) * BstSensorExt::NUM_BSTEXT_SENSORS);
@@ -356,24 +337,28 @@ sensors_poll_context_t::sensors_poll_context_t() {
         ((BstSensor *) mSensors[bst])->getSensorList(sSensorList + LOCAL_SENSORS + bst_sensor_num,
                 sizeof(sSensorList[0]) * BstSensor::NUM_SENSORS);
 
-    int wakeFds[2];
-    int result = pipe(wakeFds);
-    PERR_IF(result < 0, "error creating wake pipe (%s)", strerror(errno));
-    fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
-    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
-    mWritePipeFd = wakeFds[1];
+    int result = poll_engine_init(&mPoll);
+    PERR_IF(result < 0, "error creating poll engine (%s)", strerror(-result));
 
-    mPollFds[wake].fd = wakeFds[0];
-    mPollFds[wake].events = POLLIN;
-    mPollFds[wake].revents = 0;
+    for (int i = 0; i < numSensorDrivers; i++) {
+        result = poll_engine_add(&mPoll, mSensors[i]->getFd(), i);
+        PERR_IF(result < 0, "error polling driver %d (%s)", i, strerror(-result));
+    }
 }
 
 sensors_poll_context_t::~sensors_poll_context_t() {
     for (int i = 0; i < numSensorDrivers; i++) {
         delete mSensors[i];
     }
-    close(mPollFds[wake].fd);
-    close(mWritePipeFd);
+    poll_engine_destroy(&mPoll);
+}
+
+void sensors_poll_context_t::kick(int index) {
+    /* let pollEvents() read this driver even if its fd is quiet,
+     * it may have queued events of its own (first sample, flush complete) */
+    __atomic_or_fetch(&mKick, 1u << index, __ATOMIC_RELEASE);
+    int result = poll_engine_wake(&mPoll);
+    PERR_IF(result < 0, "error sending wake message (%s)", strerror(-result));
 }
 
 int sensors_poll_context_t::activate(int handle, int enabled) {
@@ -385,9 +370,7 @@ int sensors_poll_context_t::activate(int handle, int enabled) {
     if (index < 0) return index;
     int err = mSensors[index]->enable(handle, enabled);
     if (enabled && !err) {
-        const char wakeMessage(WAKE_MESSAGE);
-        int result = write(mWritePipeFd, &wakeMessage, 1);
-        PERR_IF(result < 0, "error sending wake message (%s)", strerror(errno));
+        kick(index);
     }
     return err;
 }
@@ -408,42 +391,47 @@ int sensors_poll_context_t::pollEvents(sensors_event_t *data, int count) {
     int n = 0;
 
     do {
-        // see if we have some leftover from the last poll()
-        for (int i = 0; count && i < numSensorDrivers; i++) {
-            SensorBase *const sensor(mSensors[i]);
-            if ((mPollFds[i].revents & POLLIN) || (sensor->hasPendingEvents())) {
-                int nb = sensor->readEvents(data, count);
-                if (nb < count) {
-                    // no more data for this sensor
-                    mPollFds[i].revents = 0;
-                }
-                count -= nb;
-                nbEvents += nb;
-                data += nb;
+        if (mReady & POLL_ENGINE_WAKE) {
+            mReady &= ~POLL_ENGINE_WAKE;
+            mReady |= __atomic_exchange_n(&mKick, 0, __ATOMIC_ACQUIRE);
+        }
+
+        // only visit drivers known to have data, and start from a different
+        // one each round so a busy sensor can't starve the others
+        int first = mNextDriver;
+        mNextDriver = (mNextDriver + 1) % numSensorDrivers;
+        for (int k = 0; count && mReady && k < numSensorDrivers; k++) {
+            int i = (first + k) % numSensorDrivers;
+            if (!(mReady & (1u << i))) {
+                continue;
+            }
+
+            int budget = count < DRIVER_EVENT_BUDGET ? count : DRIVER_EVENT_BUDGET;
+            int nb = mSensors[i]->readEvents(data, budget);
+            if (nb < budget && !mSensors[i]->hasPendingEvents()) {
+                // no more data for this sensor
+                mReady &= ~(1u << i);
             }
+            if (nb <= 0) {
+                continue;
+            }
+            count -= nb;
+            nbEvents += nb;
+            data += nb;
         }
 
         if (count) {
             // we still have some room, so try to see if we can get
             // some events immediately or just wait if we don't have
             // anything to return
-            do {
-                n = poll(mPollFds, numFds, nbEvents ? 0 : -1);
-            } while (n < 0 && errno == EINTR);
+            n = poll_engine_wait(&mPoll, &mReady, (nbEvents || mReady) ? 0 : -1);
             if (n < 0) {
-                PERR("poll() failed (%s)", strerror(errno));
-                return -errno;
-            }
-            if (mPollFds[wake].revents & POLLIN) {
-                char msg;
-                int result = read(mPollFds[wake].fd, &msg, 1);
-                PERR_IF(result < 0, "error reading from wake pipe (%s)", strerror(errno));
-                PERR_IF(msg != WAKE_MESSAGE, "unknown message on wake queue (0x%02x)", int(msg));
-                mPollFds[wake].revents = 0;
+                PERR("epoll_wait() failed (%s)", strerror(-n));
+                return n;
             }
         }
         // if we have events and space, go read them
-    } while (n && count);
+    } while ((n || mReady) && count);
 
     return nbEvents;
 }
@@ -470,7 +458,12 @@ int sensors_poll_context_t::flush(int handle) {
            handle, index);
     if (index < 0)
         return index;
-    return mSensors[index]->flush(handle);
+
+    int err = mSensors[index]->flush(handle);
+    if (!err) {
+        kick(index);
+    }
+    return err;
 }
 
 #endif
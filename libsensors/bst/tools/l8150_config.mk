@@ -123,6 +123,11 @@ debug_timing_accuracy ?= false
 # debug data log with accuracy information
 datalog_with_accuracy ?= false
 
+# replay recorded input traces instead of using the sensor hardware and log
+# per stage latency, throughput, cpu time and wakeups of the data pipeline
+# notice that this macro must be disabled before release
+debug_pipeline_bench ?= false
+
 # whether install axis configuration file the value will be
 # recognized as part of the axis configuration file name, ex.
 # if set as samsung_note, while executing "mm install", a file
@@ -149,6 +149,10 @@ ifeq (true, $(gyro_only))
 LOCAL_CFLAGS += -D__GYROONLY_WORKING_MODE_SUPPORT__
 endif
 
+ifeq (true, $(display_state_check))
+LOCAL_CFLAGS += -DCFG_CHECK_DISPLAY_STATE
+endif
+
 ifeq ($(bmi), bmi055)
 LOCAL_CFLAGS += -D__BMI055__
 LOCAL_CFLAGS += -DHW_INFO_BITWIDTH_G=16
@@ -269,6 +273,10 @@ ifeq (true,$(datalog_with_accuracy))
 LOCAL_CFLAGS += -D__DEBUG_DATALOG_WITH_ACCURACY__
 endif
 
+ifeq (true,$(debug_pipeline_bench))
+LOCAL_CFLAGS += -D__DEBUG_PIPELINE_BENCH__
+endif
+
 ifneq (, $(orientation_filt_coef))
 LOCAL_CFLAGS += -DCUST_ORIENTATION_FILT_COEF=$(orientation_filt_coef)
 endif
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AXIS_CONV_NEON 1
+#endif
+
+#include "axis_conv.h"
+
+int axis_conv_init(struct axis_conv *conv, const int src[3],
+                   const int sign[3], const float scale[3])
+{
+    int i;
+
+    memset(conv, 0, sizeof(*conv));
+
+    for (i = 0; i < 3; i++) {
+        int s = sign[i] < 0 ? -1 : 1;
+
+        if (src[i] < 0 || src[i] > 2)
+            return -1;
+
+        conv->mi[i][src[i]] = s;
+        conv->m[i][src[i]] = s * (scale ? scale[i] : 1.0f);
+    }
+
+    return 0;
+}
+
+void axis_conv_init_scale(struct axis_conv *conv, const float scale[3])
+{
+    static const int src[3] = { 0, 1, 2 };
+    static const int sign[3] = { 1, 1, 1 };
+
+    axis_conv_init(conv, src, sign, scale);
+}
+
+#define CONV_ONE(m, x, y, z, out) \
+    do { \
+        (out)[0] = (m)[0][0] * (x) + (m)[0][1] * (y) + (m)[0][2] * (z); \
+        (out)[1] = (m)[1][0] * (x) + (m)[1][1] * (y) + (m)[1][2] * (z); \
+        (out)[2] = (m)[2][0] * (x) + (m)[2][1] * (y) + (m)[2][2] * (z); \
+    } while (0)
+
+#ifdef AXIS_CONV_NEON
+static inline float32x4x3_t conv_f32x4(const struct axis_conv *conv,
+                                       float32x4_t x, float32x4_t y,
+                                       float32x4_t z)
+{
+    float32x4x3_t o;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        o.val[i] = vmulq_n_f32(x, conv->m[i][0]);
+        o.val[i] = vmlaq_n_f32(o.val[i], y, conv->m[i][1]);
+        o.val[i] = vmlaq_n_f32(o.val[i], z, conv->m[i][2]);
+    }
+
+    return o;
+}
+#endif
+
+void axis_conv_s16_f32(const struct axis_conv *conv, const int16_t *in,
+                       float *out, size_t n, size_t stride)
+{
+    size_t i = 0;
+
+#ifdef AXIS_CONV_NEON
+    if (stride == 3) {
+        for (; i + 4 <= n; i += 4) {
+            int16x4x3_t v = vld3_s16(in);
+
+            vst3q_f32(out, conv_f32x4(conv,
+                    vcvtq_f32_s32(vmovl_s16(v.val[0])),
+                    vcvtq_f32_s32(vmovl_s16(v.val[1])),
+                    vcvtq_f32_s32(vmovl_s16(v.val[2]))));
+            in += 12;
+            out += 12;
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        float x = in[0], y = in[1], z = in[2];
+
+        CONV_ONE(conv->m, x, y, z, out);
+        in += stride;
+        out += stride;
+    }
+}
+
+void axis_conv_s32_f32(const struct axis_conv *conv, const int32_t *in,
+                       float *out, size_t n, size_t stride)
+{
+    size_t i = 0;
+
+#ifdef AXIS_CONV_NEON
+    if (stride == 3) {
+        for (; i + 4 <= n; i += 4) {
+            int32x4x3_t v = vld3q_s32(in);
+
+            vst3q_f32(out, conv_f32x4(conv,
+                    vcvtq_f32_s32(v.val[0]),
+                    vcvtq_f32_s32(v.val[1]),
+                    vcvtq_f32_s32(v.val[2])));
+            in += 12;
+            out += 12;
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        float x = in[0], y = in[1], z = in[2];
+
+        CONV_ONE(conv->m, x, y, z, out);
+        in += stride;
+        out += stride;
+    }
+}
+
+void axis_conv_s32_s32(const struct axis_conv *conv, const int32_t *in,
+                       int32_t *out, size_t n, size_t stride)
+{
+    size_t i = 0;
+
+#ifdef AXIS_CONV_NEON
+    if (stride == 3) {
+        for (; i + 4 <= n; i += 4) {
+            int32x4x3_t v = vld3q_s32(in);
+            int32x4x3_t o;
+            int k;
+
+            for (k = 0; k < 3; k++) {
+                o.val[k] = vmulq_n_s32(v.val[0], conv->mi[k][0]);
+                o.val[k] = vmlaq_n_s32(o.val[k], v.val[1], conv->mi[k][1]);
+                o.val[k] = vmlaq_n_s32(o.val[k], v.val[2], conv->mi[k][2]);
+            }
+            vst3q_s32(out, o);
+            in += 12;
+            out += 12;
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        int32_t x = in[0], y = in[1], z = in[2];
+
+        CONV_ONE(conv->mi, x, y, z, out);
+        in += stride;
+        out += stride;
+    }
+}
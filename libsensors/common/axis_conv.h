@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AXIS_CONV_H
+#define AXIS_CONV_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Batched axis remap and unit conversion for XYZ sensor samples.
+ *
+ * The remap (source axis + sign per output axis) and the per-axis scale are
+ * folded once into a 3x3 signed permutation matrix, so converting a block of
+ * samples is a branch-free loop. On ARM the kernels use NEON; everywhere else
+ * a scalar loop with identical results is used.
+ *
+ * Samples are interleaved, 'stride' elements apart (3 for packed XYZ, 4 for
+ * XYZW layouts such as sensor_data_ival_t). Only the first three elements of
+ * each output sample are written. Input and output may alias when both
+ * element types have the same size and the same stride is used.
+ */
+
+struct axis_conv {
+    /* out[i] = m[i][0] * in[0] + m[i][1] * in[1] + m[i][2] * in[2] */
+    float m[3][3];
+    /* same matrix without the scale, for integer to integer remapping */
+    int32_t mi[3][3];
+};
+
+/*
+ * src[i]: index (0..2) of the input axis feeding output axis i
+ * sign[i]: negative to invert output axis i
+ * scale: per output axis scale, or NULL for 1.0
+ *
+ * Returns 0, or -1 if an index is out of range.
+ */
+int axis_conv_init(struct axis_conv *conv, const int src[3],
+                   const int sign[3], const float scale[3]);
+
+/* identity remap with the given per-axis scale (NULL for 1.0) */
+void axis_conv_init_scale(struct axis_conv *conv, const float scale[3]);
+
+void axis_conv_s16_f32(const struct axis_conv *conv, const int16_t *in,
+                       float *out, size_t n, size_t stride);
+
+void axis_conv_s32_f32(const struct axis_conv *conv, const int32_t *in,
+                       float *out, size_t n, size_t stride);
+
+/* remap only, the scale is ignored */
+void axis_conv_s32_s32(const struct axis_conv *conv, const int32_t *in,
+                       int32_t *out, size_t n, size_t stride);
+
+__END_DECLS
+
+#endif // AXIS_CONV_H
@@ -0,0 +1,352 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+#include "input_registry.h"
+
+#define SYSFS_CLASS_INPUT "/sys/class/input"
+#define DEV_INPUT "/dev/input"
+#define MAX_DEVICES 64
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct input_dev_info g_devices[MAX_DEVICES];
+/* seeded entries not checked against sysfs yet */
+static unsigned char g_unverified[MAX_DEVICES];
+static int g_count;
+static int g_valid;
+static int g_inotify_fd = -1;
+
+static int parse_num(const char *s, const char *prefix)
+{
+    size_t len = strlen(prefix);
+    char *end;
+    long n;
+
+    if (strncmp(s, prefix, len) || !s[len])
+        return -1;
+
+    n = strtol(s + len, &end, 10);
+    return (*end || n < 0) ? -1 : (int)n;
+}
+
+static int read_name(const char *path, char *name, size_t len)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    ssize_t n;
+
+    if (fd < 0)
+        return -1;
+
+    n = read(fd, name, len - 1);
+    close(fd);
+    if (n <= 0)
+        return -1;
+
+    name[n] = '\0';
+    if (name[n - 1] == '\n')
+        name[n - 1] = '\0';
+
+    return 0;
+}
+
+/* eventN handler below /sys/class/input/inputN */
+static int find_event_num(int input_num)
+{
+    char path[64];
+    struct dirent *de;
+    DIR *dir;
+    int num = -1;
+
+    snprintf(path, sizeof(path), SYSFS_CLASS_INPUT "/input%d", input_num);
+    dir = opendir(path);
+    if (!dir)
+        return -1;
+
+    while ((de = readdir(dir))) {
+        num = parse_num(de->d_name, "event");
+        if (num >= 0)
+            break;
+    }
+    closedir(dir);
+
+    return num;
+}
+
+static void scan_sysfs_locked(void)
+{
+    char path[64];
+    struct dirent *de;
+    DIR *dir;
+
+    dir = opendir(SYSFS_CLASS_INPUT);
+    if (!dir)
+        return;
+
+    while (g_count < MAX_DEVICES && (de = readdir(dir))) {
+        struct input_dev_info *info = &g_devices[g_count];
+        int num = parse_num(de->d_name, "input");
+
+        if (num < 0)
+            continue;
+
+        snprintf(path, sizeof(path), SYSFS_CLASS_INPUT "/input%d/name", num);
+        if (read_name(path, info->name, sizeof(info->name)))
+            continue;
+
+        info->input_num = num;
+        info->event_num = find_event_num(num);
+        g_count++;
+    }
+    closedir(dir);
+}
+
+/* fallback when sysfs is not readable: ask every event node for its name */
+static void scan_dev_locked(void)
+{
+    char path[64];
+    struct dirent *de;
+    DIR *dir;
+
+    dir = opendir(DEV_INPUT);
+    if (!dir)
+        return;
+
+    while (g_count < MAX_DEVICES && (de = readdir(dir))) {
+        struct input_dev_info *info = &g_devices[g_count];
+        int num = parse_num(de->d_name, "event");
+        int fd;
+
+        if (num < 0)
+            continue;
+
+        snprintf(path, sizeof(path), DEV_INPUT "/event%d", num);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        if (ioctl(fd, EVIOCGNAME(sizeof(info->name) - 1), info->name) < 1)
+            info->name[0] = '\0';
+        info->name[sizeof(info->name) - 1] = '\0';
+        close(fd);
+
+        info->input_num = -1;
+        info->event_num = num;
+        g_count++;
+    }
+    closedir(dir);
+}
+
+static void check_hotplug_locked(void)
+{
+    char buf[512];
+
+    if (g_inotify_fd < 0) {
+        g_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (g_inotify_fd >= 0 &&
+                inotify_add_watch(g_inotify_fd, DEV_INPUT,
+                                  IN_CREATE | IN_DELETE) < 0) {
+            close(g_inotify_fd);
+            g_inotify_fd = -1;
+        }
+        /* anything that happened before the watch is covered by a rescan */
+        g_valid = 0;
+        return;
+    }
+
+    /* any pending notification means the device set changed */
+    while (read(g_inotify_fd, buf, sizeof(buf)) > 0)
+        g_valid = 0;
+}
+
+static int compare_num(const void *a, const void *b)
+{
+    const struct input_dev_info *da = a;
+    const struct input_dev_info *db = b;
+
+    if (da->input_num != db->input_num)
+        return da->input_num < db->input_num ? -1 : 1;
+    if (da->event_num != db->event_num)
+        return da->event_num < db->event_num ? -1 : 1;
+    return 0;
+}
+
+static void rescan_locked(void)
+{
+    memset(g_unverified, 0, sizeof(g_unverified));
+    g_count = 0;
+    scan_sysfs_locked();
+    if (!g_count)
+        scan_dev_locked();
+    /* readdir order is arbitrary, a prefix must match the lowest number */
+    qsort(g_devices, g_count, sizeof(g_devices[0]), compare_num);
+    g_valid = 1;
+}
+
+/* a seeded entry still names the same device */
+static int verify_locked(int i)
+{
+    char path[64];
+    char name[INPUT_REGISTRY_NAME_MAX];
+    const struct input_dev_info *info = &g_devices[i];
+
+    if (info->input_num >= 0) {
+        snprintf(path, sizeof(path), SYSFS_CLASS_INPUT "/input%d/name",
+                 info->input_num);
+        if (read_name(path, name, sizeof(name)) ||
+                strcmp(name, info->name))
+            return 0;
+
+        if (info->event_num >= 0 &&
+                find_event_num(info->input_num) != info->event_num)
+            return 0;
+    } else if (info->event_num >= 0) {
+        snprintf(path, sizeof(path), DEV_INPUT "/event%d", info->event_num);
+        if (access(path, F_OK))
+            return 0;
+    }
+
+    g_unverified[i] = 0;
+    return 1;
+}
+
+static int lookup_locked(const char *name, int flags,
+                         struct input_dev_info *info)
+{
+    size_t len = strlen(name);
+    int i;
+
+    for (i = 0; i < g_count; i++) {
+        const char *dev = g_devices[i].name;
+        int match = (flags & INPUT_REGISTRY_PREFIX) ?
+                !strncmp(dev, name, len) : !strcmp(dev, name);
+
+        if (match) {
+            if (g_unverified[i] && !verify_locked(i))
+                return -ENODEV;
+
+            *info = g_devices[i];
+            return 0;
+        }
+    }
+
+    return -ENODEV;
+}
+
+int input_registry_find(const char *name, int flags,
+                        struct input_dev_info *info)
+{
+    int err;
+
+    pthread_mutex_lock(&g_lock);
+
+    check_hotplug_locked();
+    if (!g_valid)
+        rescan_locked();
+
+    err = lookup_locked(name, flags, info);
+    if (err) {
+        /* the device may have shown up without us being told */
+        rescan_locked();
+        err = lookup_locked(name, flags, info);
+    }
+
+    pthread_mutex_unlock(&g_lock);
+
+    return err;
+}
+
+int input_registry_open_event(const char *name, char *node_name,
+                              size_t node_name_len)
+{
+    struct input_dev_info info;
+    char path[64];
+    int fd;
+
+    if (input_registry_find(name, 0, &info) || info.event_num < 0)
+        return -1;
+
+    snprintf(path, sizeof(path), DEV_INPUT "/event%d", info.event_num);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        /* stale entry, the next lookup starts over */
+        input_registry_invalidate();
+        return -1;
+    }
+
+    if (node_name)
+        snprintf(node_name, node_name_len, "event%d", info.event_num);
+
+    return fd;
+}
+
+void input_registry_invalidate(void)
+{
+    pthread_mutex_lock(&g_lock);
+    g_valid = 0;
+    pthread_mutex_unlock(&g_lock);
+}
+
+int input_registry_export(struct input_dev_info *infos, int max)
+{
+    int n;
+
+    pthread_mutex_lock(&g_lock);
+
+    check_hotplug_locked();
+    if (!g_valid)
+        rescan_locked();
+
+    n = g_count < max ? g_count : max;
+    memcpy(infos, g_devices, n * sizeof(*infos));
+
+    pthread_mutex_unlock(&g_lock);
+
+    return n;
+}
+
+void input_registry_seed(const struct input_dev_info *infos, int n)
+{
+    int i;
+
+    if (n > MAX_DEVICES)
+        n = MAX_DEVICES;
+
+    pthread_mutex_lock(&g_lock);
+
+    /* set the watch up first, so that it does not drop the seed */
+    check_hotplug_locked();
+
+    for (i = 0; i < n; i++) {
+        g_devices[i] = infos[i];
+        g_devices[i].name[sizeof(g_devices[i].name) - 1] = '\0';
+        g_unverified[i] = 1;
+    }
+    g_count = n;
+    g_valid = 1;
+
+    pthread_mutex_unlock(&g_lock);
+}
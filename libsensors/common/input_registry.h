@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INPUT_REGISTRY_H
+#define INPUT_REGISTRY_H
+
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Process wide cache of input device name -> inputN / eventN numbers.
+ *
+ * The cache is filled from /sys/class/input/input*\/name without opening
+ * any device node, and falls back to EVIOCGNAME on /dev/input/event* only
+ * when sysfs yields nothing. An inotify watch on /dev/input invalidates it
+ * when devices come or go, and a lookup that misses rescans once.
+ */
+
+#define INPUT_REGISTRY_NAME_MAX 80
+
+/* match devices whose name starts with the given one */
+#define INPUT_REGISTRY_PREFIX 0x1
+
+struct input_dev_info {
+    char name[INPUT_REGISTRY_NAME_MAX];
+    /* N of /sys/class/input/inputN, -1 if unknown */
+    int input_num;
+    /* N of /dev/input/eventN, -1 if the device has no event handler */
+    int event_num;
+};
+
+/* returns 0 and fills info, or -ENODEV */
+int input_registry_find(const char *name, int flags,
+                        struct input_dev_info *info);
+
+/*
+ * Open /dev/input/eventN of the named device read-only. On success the
+ * node name ("eventN") is copied to node_name if it is not NULL.
+ * Returns the fd or -1.
+ */
+int input_registry_open_event(const char *name, char *node_name,
+                              size_t node_name_len);
+
+/* drop the cache, the next lookup rescans */
+void input_registry_invalidate(void);
+
+/* copy up to max cached entries to infos, returns the number copied */
+int input_registry_export(struct input_dev_info *infos, int max);
+
+/*
+ * Fill the cache from entries saved by a previous process instead of
+ * scanning. Every seeded entry is checked against sysfs on its first
+ * hit, a stale one makes that lookup rescan.
+ */
+void input_registry_seed(const struct input_dev_info *infos, int n);
+
+__END_DECLS
+
+#endif // INPUT_REGISTRY_H
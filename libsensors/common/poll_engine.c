@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "poll_engine.h"
+
+#define WAKE_INDEX POLL_ENGINE_MAX_DRIVERS
+
+int poll_engine_init(struct poll_engine *pe)
+{
+    struct epoll_event ev;
+    int err;
+
+    pe->wake_fd = -1;
+    pe->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (pe->epoll_fd < 0)
+        return -errno;
+
+    pe->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (pe->wake_fd < 0) {
+        err = -errno;
+        poll_engine_destroy(pe);
+        return err;
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.u32 = WAKE_INDEX;
+    if (epoll_ctl(pe->epoll_fd, EPOLL_CTL_ADD, pe->wake_fd, &ev)) {
+        err = -errno;
+        poll_engine_destroy(pe);
+        return err;
+    }
+
+    return 0;
+}
+
+void poll_engine_destroy(struct poll_engine *pe)
+{
+    if (pe->wake_fd >= 0)
+        close(pe->wake_fd);
+    if (pe->epoll_fd >= 0)
+        close(pe->epoll_fd);
+    pe->wake_fd = pe->epoll_fd = -1;
+}
+
+int poll_engine_add(struct poll_engine *pe, int fd, int index)
+{
+    struct epoll_event ev;
+
+    if (index < 0 || index >= POLL_ENGINE_MAX_DRIVERS)
+        return -EINVAL;
+    if (fd < 0)
+        return 0;
+
+    ev.events = EPOLLIN;
+    ev.data.u32 = index;
+    if (epoll_ctl(pe->epoll_fd, EPOLL_CTL_ADD, fd, &ev))
+        return -errno;
+
+    return 0;
+}
+
+int poll_engine_wake(struct poll_engine *pe)
+{
+    uint64_t one = 1;
+
+    /* EAGAIN only means the counter is already non-zero */
+    if (write(pe->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        return -errno;
+
+    return 0;
+}
+
+int poll_engine_wait(struct poll_engine *pe, uint32_t *ready, int timeout)
+{
+    struct epoll_event events[POLL_ENGINE_MAX_DRIVERS + 1];
+    uint64_t count;
+    int i, n;
+
+    do {
+        n = epoll_wait(pe->epoll_fd, events,
+                       POLL_ENGINE_MAX_DRIVERS + 1, timeout);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0)
+        return -errno;
+
+    for (i = 0; i < n; i++) {
+        uint32_t index = events[i].data.u32;
+
+        if (index == WAKE_INDEX) {
+            /* one read resets the counter, however many wakes piled up */
+            if (read(pe->wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+                return -errno;
+            *ready |= POLL_ENGINE_WAKE;
+        } else {
+            *ready |= 1u << index;
+        }
+    }
+
+    return n;
+}
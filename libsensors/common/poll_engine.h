@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef POLL_ENGINE_H
+#define POLL_ENGINE_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Readiness tracking for the sensors HAL poll loop.
+ *
+ * Driver fds are registered once in a persistent epoll set under their
+ * driver index, and an eventfd replaces the old wake pipe. A wait
+ * reports the ready drivers as a bit mask, so the caller only has to
+ * look at drivers that actually have something to read.
+ */
+
+#define POLL_ENGINE_MAX_DRIVERS 31
+/* set in the ready mask when poll_engine_wake() was called */
+#define POLL_ENGINE_WAKE (1u << POLL_ENGINE_MAX_DRIVERS)
+
+struct poll_engine {
+    int epoll_fd;
+    int wake_fd;
+};
+
+int poll_engine_init(struct poll_engine *pe);
+void poll_engine_destroy(struct poll_engine *pe);
+
+/* fds < 0 (driver not present) are ignored */
+int poll_engine_add(struct poll_engine *pe, int fd, int index);
+
+/* make a blocked or the next poll_engine_wait() return */
+int poll_engine_wake(struct poll_engine *pe);
+
+/*
+ * Wait up to timeout ms (-1 forever) and OR the ready drivers into
+ * *ready. A pending wake is consumed and reported as POLL_ENGINE_WAKE.
+ * Returns the number of ready fds or -errno.
+ */
+int poll_engine_wait(struct poll_engine *pe, uint32_t *ready, int timeout);
+
+__END_DECLS
+
+#endif // POLL_ENGINE_H
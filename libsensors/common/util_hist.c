@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util_hist.h"
+
+void util_hist_add(struct util_hist *hist, uint32_t us)
+{
+    uint32_t max;
+    uint32_t v;
+    int b = 0;
+
+    for (v = us; v > 1 && b < UTIL_HIST_BUCKETS - 1; v >>= 1)
+        b++;
+
+    __atomic_add_fetch(&hist->buckets[b], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->total, us, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->count, 1, __ATOMIC_RELAXED);
+
+    max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+    while (us > max && !__atomic_compare_exchange_n(&hist->max, &max, us, 1,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+void util_hist_take(struct util_hist *hist, struct util_hist *snap)
+{
+    int b;
+
+    snap->count = __atomic_exchange_n(&hist->count, 0, __ATOMIC_RELAXED);
+    snap->total = __atomic_exchange_n(&hist->total, 0, __ATOMIC_RELAXED);
+    snap->max = __atomic_exchange_n(&hist->max, 0, __ATOMIC_RELAXED);
+    for (b = 0; b < UTIL_HIST_BUCKETS; b++)
+        snap->buckets[b] = __atomic_exchange_n(&hist->buckets[b], 0,
+                                               __ATOMIC_RELAXED);
+}
+
+uint32_t util_hist_percentile(const struct util_hist *hist, int pct)
+{
+    uint32_t target = (uint32_t)(((uint64_t)hist->count * pct + 99) / 100);
+    uint32_t seen = 0;
+    int b;
+
+    for (b = 0; b < UTIL_HIST_BUCKETS - 1; b++) {
+        seen += hist->buckets[b];
+        if (seen >= target)
+            break;
+    }
+
+    return 2u << b;
+}
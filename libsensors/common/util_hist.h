@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTIL_HIST_H
+#define UTIL_HIST_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * log2 histogram of durations in us, shared by the sensord telemetry,
+ * its pipeline benchmark and the HAL. Samples are added with relaxed
+ * atomics, so several threads may feed one histogram; readers in other
+ * threads may see a sample half accounted for, which is fine for
+ * telemetry.
+ */
+
+#define UTIL_HIST_BUCKETS 20
+
+struct util_hist {
+    uint32_t count;
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[UTIL_HIST_BUCKETS];
+};
+
+void util_hist_add(struct util_hist *hist, uint32_t us);
+
+/* move the samples of hist to snap, leaving hist empty */
+void util_hist_take(struct util_hist *hist, struct util_hist *snap);
+
+/* upper bound of the bucket holding the pct percentile, in us */
+uint32_t util_hist_percentile(const struct util_hist *hist, int pct);
+
+__END_DECLS
+
+#endif
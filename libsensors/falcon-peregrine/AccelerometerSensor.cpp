@@ -26,8 +26,11 @@ AccelerometerSensor::AccelerometerSensor()
       mEnabled(0),
       mOriEnabled(false),
       mInputReader(8),
-      mPendingEventsMask(0)
+      mPendingEventsMask(0),
+      mAkmFeeder("/sys/devices/virtual/compass/akm8963/accel")
 {
+    static const float scale[3] = { CONVERT_A_X, CONVERT_A_Y, CONVERT_A_Z };
+
     mPendingEvents[ACC].version = sizeof(sensors_event_t);
     mPendingEvents[ACC].sensor = ID_A;
     mPendingEvents[ACC].type = SENSOR_TYPE_ACCELEROMETER;
@@ -45,6 +48,9 @@ AccelerometerSensor::AccelerometerSensor()
     mPendingEvents[SM].type = SENSOR_TYPE_SIGNIFICANT_MOTION;
     memset(mPendingEvents[SM].data, 0, sizeof(mPendingEvents[SM].data));
     mPendingEventsFlushCount[SM] = 0;
+
+    memset(mRawAccel, 0, sizeof(mRawAccel));
+    axis_conv_init_scale(&mAccelConv, scale);
 }
 
 AccelerometerSensor::~AccelerometerSensor()
@@ -84,6 +90,7 @@ int AccelerometerSensor::enable(int32_t handle, int en)
     case ID_O:
         ALOGV("Accelerometer (ORI): enable=%d", en);
         mOriEnabled = !!en;
+        mAkmFeeder.reset();
         /* We are not enabling/disabling an actual sensor */
         return 0;
     default:
@@ -111,29 +118,6 @@ int AccelerometerSensor::enable(int32_t handle, int en)
     return 0;
 }
 
-void AccelerometerSensor::writeAkmAccel(float x, float y, float z)
-{
-    int16_t buf[3];
-    int ret;
-    int fd;
-
-    buf[0] = (int16_t) (x * CONVERT_ACC);
-    buf[1] = (int16_t) (y * CONVERT_ACC);
-    buf[2] = (int16_t) (z * CONVERT_ACC);
-
-    fd = open("/sys/devices/virtual/compass/akm8963/accel", O_WRONLY);
-    if (fd < 0) {
-        ALOGE("Accelerometer: could not open accel file");
-        return;
-    }
-
-    ret = write(fd, buf, sizeof(buf));
-    if (ret < 0)
-        ALOGE("Accelerometer: could not write accel data");
-
-    close(fd);
-}
-
 int AccelerometerSensor::setDelay(int32_t handle, int64_t ns)
 {
     int delay = ns / 1000000;
@@ -150,6 +134,11 @@ int AccelerometerSensor::setDelay(int32_t handle, int64_t ns)
         /* Significant motion sensors should not set any delay */
         ALOGV("Accelerometer (SM): ignoring delay=%lld", ns);
         return 0;
+    case ID_O:
+        /* Only the rate samples are forwarded to the AKM driver at */
+        ALOGV("Accelerometer (ORI): feed delay=%lld", ns);
+        mAkmFeeder.setDelay(ns);
+        return 0;
     }
 
     if (delay > ACC_MAX_DELAY_MS)
@@ -210,16 +199,15 @@ int AccelerometerSensor::readEvents(sensors_event_t* data, int count)
     while (count && mInputReader.readEvent(&event)) {
         int type = event->type;
         if (type == EV_ABS) {
-            float value = event->value;
             if (event->code == EVENT_TYPE_ACCEL_X) {
                 mPendingEventsMask |= 1 << ACC;
-                mPendingEvents[ACC].acceleration.x = value * CONVERT_A_X;
+                mRawAccel[0] = event->value;
             } else if (event->code == EVENT_TYPE_ACCEL_Y) {
                 mPendingEventsMask |= 1 << ACC;
-                mPendingEvents[ACC].acceleration.y = value * CONVERT_A_Y;
+                mRawAccel[1] = event->value;
             } else if (event->code == EVENT_TYPE_ACCEL_Z) {
                 mPendingEventsMask |= 1 << ACC;
-                mPendingEvents[ACC].acceleration.z = value * CONVERT_A_Z;
+                mRawAccel[2] = event->value;
             } else {
                 ALOGE("Accelerometer: unknown event (type=%d, code=%d)",
                         type, event->code);
@@ -236,6 +224,10 @@ int AccelerometerSensor::readEvents(sensors_event_t* data, int count)
                         type, event->code);
             }
         } else if (type == EV_SYN) {
+            if (mPendingEventsMask & (1 << ACC))
+                axis_conv_s32_f32(&mAccelConv, mRawAccel,
+                                  mPendingEvents[ACC].acceleration.v, 1, 3);
+
             for (int i = 0; count && mPendingEventsMask && i < NUM_SENSORS; i++) {
                 if (mPendingEventsMask & (1 << i)) {
                     mPendingEventsMask &= ~(1 << i);
@@ -251,9 +243,10 @@ int AccelerometerSensor::readEvents(sensors_event_t* data, int count)
                     }
 
                     if (i == ACC && mOriEnabled)
-                        writeAkmAccel(mPendingEvents[ACC].acceleration.x,
-                                      mPendingEvents[ACC].acceleration.y,
-                                      mPendingEvents[ACC].acceleration.z);
+                        mAkmFeeder.push(mPendingEvents[ACC].acceleration.x,
+                                        mPendingEvents[ACC].acceleration.y,
+                                        mPendingEvents[ACC].acceleration.z,
+                                        mPendingEvents[ACC].timestamp);
                 }
             }
         } else {
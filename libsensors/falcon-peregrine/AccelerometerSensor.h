@@ -21,6 +21,8 @@
 #include "sensors.h"
 #include "SensorBase.h"
 #include "InputEventReader.h"
+#include "axis_conv.h"
+#include "AkmAccelFeeder.h"
 
 
 #define LIS3DH_IOCTL_BASE		71
@@ -66,7 +68,9 @@ private:
     sensors_event_t mPendingEvents[NUM_SENSORS];
     uint32_t mPendingEventsMask;
     int mPendingEventsFlushCount[NUM_SENSORS];
-    void writeAkmAccel(float x, float y, float z);
+    int32_t mRawAccel[3];
+    struct axis_conv mAccelConv;
+    AkmAccelFeeder mAkmFeeder;
 
 public:
             AccelerometerSensor();
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <cutils/log.h>
+
+#include "sensors.h"
+#include "AkmAccelFeeder.h"
+
+AkmAccelFeeder::AkmAccelFeeder(const char* path)
+    : mPath(path),
+      mFd(-1),
+      mWarned(false),
+      mDelayNs(0),
+      mLastTimestamp(0)
+{
+#ifdef AKM_ACCEL_FEED_ASYNC
+    pthread_mutex_init(&mLock, NULL);
+    pthread_cond_init(&mCond, NULL);
+    mPending = false;
+    mExit = false;
+    memset(mSample, 0, sizeof(mSample));
+
+    mThreadStarted = !pthread_create(&mThread, NULL, threadLoop, this);
+    ALOGE_IF(!mThreadStarted, "AkmAccelFeeder: could not start thread");
+#endif
+}
+
+AkmAccelFeeder::~AkmAccelFeeder()
+{
+#ifdef AKM_ACCEL_FEED_ASYNC
+    if (mThreadStarted) {
+        pthread_mutex_lock(&mLock);
+        mExit = true;
+        pthread_cond_signal(&mCond);
+        pthread_mutex_unlock(&mLock);
+        pthread_join(mThread, NULL);
+    }
+    pthread_cond_destroy(&mCond);
+    pthread_mutex_destroy(&mLock);
+#endif
+
+    if (mFd >= 0)
+        close(mFd);
+}
+
+void AkmAccelFeeder::setDelay(int64_t ns)
+{
+    mDelayNs = ns > 0 ? ns : 0;
+}
+
+void AkmAccelFeeder::reset()
+{
+    mLastTimestamp = 0;
+}
+
+int AkmAccelFeeder::writeSample(const int16_t* buf)
+{
+    for (int retry = 0; retry < 2; retry++) {
+        if (mFd < 0) {
+            mFd = open(mPath, O_WRONLY | O_CLOEXEC);
+            if (mFd < 0) {
+                if (!mWarned)
+                    ALOGE("Accelerometer: could not open accel file");
+                mWarned = true;
+                return -errno;
+            }
+        }
+
+        if (write(mFd, buf, 3 * sizeof(int16_t)) >= 0) {
+            mWarned = false;
+            return 0;
+        }
+
+        /* reopen once, the node may have been recreated */
+        close(mFd);
+        mFd = -1;
+    }
+
+    if (!mWarned)
+        ALOGE("Accelerometer: could not write accel data");
+    mWarned = true;
+
+    return -EIO;
+}
+
+void AkmAccelFeeder::push(float x, float y, float z, int64_t timestamp)
+{
+    int16_t buf[3];
+
+    /* allow 1/8 of jitter so a sample that is slightly early isn't dropped */
+    if (mDelayNs && mLastTimestamp &&
+            timestamp - mLastTimestamp < mDelayNs - (mDelayNs >> 3))
+        return;
+    mLastTimestamp = timestamp;
+
+    buf[0] = (int16_t) (x * CONVERT_ACC_X);
+    buf[1] = (int16_t) (y * CONVERT_ACC_Y);
+    buf[2] = (int16_t) (z * CONVERT_ACC_Z);
+
+#ifdef AKM_ACCEL_FEED_ASYNC
+    if (mThreadStarted) {
+        pthread_mutex_lock(&mLock);
+        memcpy(mSample, buf, sizeof(mSample));
+        mPending = true;
+        pthread_cond_signal(&mCond);
+        pthread_mutex_unlock(&mLock);
+        return;
+    }
+#endif
+
+    writeSample(buf);
+}
+
+#ifdef AKM_ACCEL_FEED_ASYNC
+void* AkmAccelFeeder::threadLoop(void* arg)
+{
+    AkmAccelFeeder* self = static_cast<AkmAccelFeeder*>(arg);
+    int16_t buf[3];
+
+    pthread_mutex_lock(&self->mLock);
+    for (;;) {
+        while (!self->mPending && !self->mExit)
+            pthread_cond_wait(&self->mCond, &self->mLock);
+        if (self->mExit)
+            break;
+
+        /* older samples that were never written are simply superseded */
+        memcpy(buf, self->mSample, sizeof(buf));
+        self->mPending = false;
+
+        pthread_mutex_unlock(&self->mLock);
+        self->writeSample(buf);
+        pthread_mutex_lock(&self->mLock);
+    }
+    pthread_mutex_unlock(&self->mLock);
+
+    return NULL;
+}
+#endif
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2016 The CyanogenMod Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AKM_ACCEL_FEEDER_H
+#define ANDROID_AKM_ACCEL_FEEDER_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+/*
+ * Feeds accelerometer samples to the AKM compass driver, which needs them
+ * for its orientation fusion.
+ *
+ * The sysfs node is kept open and only reopened after a write error, and
+ * samples are decimated to the orientation rate set with setDelay(). With
+ * AKM_ACCEL_FEED_ASYNC the write is done by a side thread that always
+ * pushes the latest sample, so the poll thread never blocks on sysfs.
+ */
+class AkmAccelFeeder {
+
+private:
+    const char* mPath;
+    int mFd;
+    bool mWarned;
+    int64_t mDelayNs;
+    int64_t mLastTimestamp;
+
+#ifdef AKM_ACCEL_FEED_ASYNC
+    pthread_t mThread;
+    pthread_mutex_t mLock;
+    pthread_cond_t mCond;
+    bool mThreadStarted;
+    bool mPending;
+    bool mExit;
+    int16_t mSample[3];
+
+    static void* threadLoop(void* arg);
+#endif
+
+    int writeSample(const int16_t* buf);
+
+public:
+            AkmAccelFeeder(const char* path);
+            ~AkmAccelFeeder();
+
+    /* rate the AKM fusion consumes samples at, 0 to forward every sample */
+    void setDelay(int64_t ns);
+
+    /* forget the decimation state so the next sample goes out at once */
+    void reset();
+
+    void push(float x, float y, float z, int64_t timestamp);
+};
+
+#endif  // ANDROID_AKM_ACCEL_FEEDER_H
@@ -23,6 +23,10 @@ include $(CLEAR_VARS)
 # the sensors, possibly leading to conflicts.
 DISPLAY_ROTATION_SENSOR_ENABLED := false
 
+# Push accelerometer samples to the AKM compass driver from a side thread
+# instead of writing sysfs from the poll thread.
+AKM_ACCEL_FEED_ASYNC := true
+
 LOCAL_MODULE := sensors.$(TARGET_BOARD_PLATFORM)
 
 LOCAL_MODULE_PATH := $(TARGET_OUT_SHARED_LIBRARIES)/hw
@@ -37,7 +41,13 @@ LOCAL_SRC_FILES := \
     LightProxSensor.cpp \
     AccelerometerSensor.cpp \
     CompOriSensor.cpp \
-    InputEventReader.cpp
+    AkmAccelFeeder.cpp \
+    InputEventReader.cpp \
+    ../common/axis_conv.c \
+    ../common/input_registry.c \
+    ../common/poll_engine.c
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../common
 
 ifneq ($(filter peregrine, $(TARGET_DEVICE)),)
     LOCAL_CFLAGS += -DWITH_GYROSCOPE
@@ -48,6 +58,10 @@ ifeq ($(DISPLAY_ROTATION_SENSOR_ENABLED), true)
     LOCAL_CFLAGS += -DWITH_DISPLAY_ROTATION_SENSOR
 endif
 
+ifeq ($(AKM_ACCEL_FEED_ASYNC), true)
+    LOCAL_CFLAGS += -DAKM_ACCEL_FEED_ASYNC
+endif
+
 LOCAL_SHARED_LIBRARIES := liblog libcutils libdl
 
 include $(BUILD_SHARED_LIBRARY)
@@ -27,10 +27,15 @@ GyroscopeSensor::GyroscopeSensor()
       mInputReader(4),
       mPendingEventsFlushCount(0)
 {
+    static const float scale[3] = { CONVERT_G_X, CONVERT_G_Y, CONVERT_G_Z };
+
     mPendingEvents.version = sizeof(sensors_event_t);
     mPendingEvents.sensor = ID_GY;
     mPendingEvents.type = SENSOR_TYPE_GYROSCOPE;
     memset(mPendingEvents.data, 0, sizeof(mPendingEvents.data));
+
+    memset(mRawGyro, 0, sizeof(mRawGyro));
+    axis_conv_init_scale(&mGyroConv, scale);
 }
 
 GyroscopeSensor::~GyroscopeSensor()
@@ -103,13 +108,12 @@ int GyroscopeSensor::readEvents(sensors_event_t* data, int count)
     while (count && mInputReader.readEvent(&event)) {
         int type = event->type;
         if (type == EV_REL) {
-            float value = event->value;
             if (event->code == EVENT_TYPE_GYRO_X) {
-                mPendingEvents.gyro.x = value * CONVERT_G_X;
+                mRawGyro[0] = event->value;
             } else if (event->code == EVENT_TYPE_GYRO_Y) {
-                mPendingEvents.gyro.y = value * CONVERT_G_Y;
+                mRawGyro[1] = event->value;
             } else if (event->code == EVENT_TYPE_GYRO_Z) {
-                mPendingEvents.gyro.z = value * CONVERT_G_Z;
+                mRawGyro[2] = event->value;
             } else {
                 ALOGE("Gyroscope: unknown event (type=%d, code=%d)",
                         type, event->code);
@@ -117,6 +121,8 @@ int GyroscopeSensor::readEvents(sensors_event_t* data, int count)
         } else if (type == EV_SYN) {
             mPendingEvents.timestamp = timevalToNano(event->time);
             if (mEnabled) {
+                axis_conv_s32_f32(&mGyroConv, mRawGyro,
+                                  mPendingEvents.gyro.v, 1, 3);
                 *data++ = mPendingEvents;
                 count--;
                 numEventReceived++;
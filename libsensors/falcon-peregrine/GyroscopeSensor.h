@@ -21,6 +21,7 @@
 #include "sensors.h"
 #include "SensorBase.h"
 #include "InputEventReader.h"
+#include "axis_conv.h"
 
 
 #define L3G4200D_IOCTL_BASE		77
@@ -37,6 +38,8 @@ private:
     InputEventCircularReader mInputReader;
     sensors_event_t mPendingEvents;
     int mPendingEventsFlushCount;
+    int32_t mRawGyro[3];
+    struct axis_conv mGyroConv;
 
 public:
             GyroscopeSensor();
@@ -21,6 +21,7 @@
 #include <string.h>
 
 #include "SensorBase.h"
+#include "input_registry.h"
 
 /*****************************************************************************/
 
@@ -91,40 +92,8 @@ int64_t SensorBase::getTimestamp()
 
 int SensorBase::openInput(const char* inputName)
 {
-    int fd = -1;
-    const char *dirname = "/dev/input";
-    char devname[PATH_MAX];
-    char *filename;
-    DIR *dir;
-    struct dirent *de;
-    dir = opendir(dirname);
-    if (dir == NULL)
-        return -1;
-    strcpy(devname, dirname);
-    filename = devname + strlen(devname);
-    *filename++ = '/';
-    while ((de = readdir(dir))) {
-        if (de->d_name[0] == '.' &&
-                (de->d_name[1] == '\0' ||
-                        (de->d_name[1] == '.' && de->d_name[2] == '\0')))
-            continue;
-        strcpy(filename, de->d_name);
-        fd = open(devname, O_RDONLY);
-        if (fd >= 0) {
-            char name[80];
-            if (ioctl(fd, EVIOCGNAME(sizeof(name) - 1), &name) < 1) {
-                name[0] = '\0';
-            }
-            if (!strcmp(name, inputName)) {
-                strcpy(input_name, filename);
-                break;
-            } else {
-                close(fd);
-                fd = -1;
-            }
-        }
-    }
-    closedir(dir);
+    /* the registry caches the name -> eventN mapping across sensors */
+    int fd = input_registry_open_event(inputName, input_name, sizeof(input_name));
     ALOGE_IF(fd < 0, "couldn't find '%s' input device", inputName);
     return fd;
 }
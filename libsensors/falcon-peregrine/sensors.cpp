@@ -17,11 +17,11 @@
 
 #include <hardware/sensors.h>
 #include <fcntl.h>
-#include <poll.h>
 #include <string.h>
 #include <utils/Log.h>
 
 #include "sensors.h"
+#include "poll_engine.h"
 #include "LightProxSensor.h"
 #include "AccelerometerSensor.h"
 #include "CompOriSensor.h"
@@ -38,6 +38,9 @@
 #define SENSORS_SIGNIFICANT_MOTION_HANDLE (ID_SM)
 #define SENSORS_GYROSCOPE_HANDLE          (ID_GY)
 
+// events a single driver may return per round before the others get a turn
+#define DRIVER_EVENT_BUDGET 64
+
 /*****************************************************************************/
 
 static struct sensor_t sSensorList[] = {
@@ -241,13 +244,12 @@ private:
         gyro,
 #endif
         numSensorDrivers,
-        numFds,
     };
 
-    static const size_t wake = numFds - 1;
-    static const char WAKE_MESSAGE = 'W';
-    struct pollfd mPollFds[numFds];
-    int mWritePipeFd;
+    struct poll_engine mPoll;
+    uint32_t mReady;
+    uint32_t mKick;
+    int mNextDriver;
     SensorBase* mSensors[numSensorDrivers];
 
     bool mAccelActive;
@@ -256,6 +258,7 @@ private:
     int mOriDelay;
 
     int realActivate(int handle, int enabled);
+    void kick(int index);
 
     int handleToDriver(int handle) const {
         switch (handle) {
@@ -282,39 +285,22 @@ private:
 /*****************************************************************************/
 
 sensors_poll_context_t::sensors_poll_context_t()
+    : mReady(0), mKick(0), mNextDriver(0)
 {
     mSensors[lightProx] = new LightProxSensor();
-    mPollFds[lightProx].fd = mSensors[lightProx]->getFd();
-    mPollFds[lightProx].events = POLLIN;
-    mPollFds[lightProx].revents = 0;
-
     mSensors[accel] = new AccelerometerSensor();
-    mPollFds[accel].fd = mSensors[accel]->getFd();
-    mPollFds[accel].events = POLLIN;
-    mPollFds[accel].revents = 0;
-
     mSensors[compOri] = new CompOriSensor();
-    mPollFds[compOri].fd = mSensors[compOri]->getFd();
-    mPollFds[compOri].events = POLLIN;
-    mPollFds[compOri].revents = 0;
-
 #ifdef WITH_GYROSCOPE
     mSensors[gyro] = new GyroscopeSensor();
-    mPollFds[gyro].fd = mSensors[gyro]->getFd();
-    mPollFds[gyro].events = POLLIN;
-    mPollFds[gyro].revents = 0;
 #endif
 
-    int wakeFds[2];
-    int result = pipe(wakeFds);
-    ALOGE_IF(result < 0, "error creating wake pipe (%s)", strerror(errno));
-    fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
-    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
-    mWritePipeFd = wakeFds[1];
+    int result = poll_engine_init(&mPoll);
+    ALOGE_IF(result < 0, "error creating poll engine (%s)", strerror(-result));
 
-    mPollFds[wake].fd = wakeFds[0];
-    mPollFds[wake].events = POLLIN;
-    mPollFds[wake].revents = 0;
+    for (int i = 0; i < numSensorDrivers; i++) {
+        result = poll_engine_add(&mPoll, mSensors[i]->getFd(), i);
+        ALOGE_IF(result < 0, "error polling driver %d (%s)", i, strerror(-result));
+    }
 }
 
 sensors_poll_context_t::~sensors_poll_context_t()
@@ -322,8 +308,16 @@ sensors_poll_context_t::~sensors_poll_context_t()
     for (int i = 0 ; i < numSensorDrivers ; i++) {
         delete mSensors[i];
     }
-    close(mPollFds[wake].fd);
-    close(mWritePipeFd);
+    poll_engine_destroy(&mPoll);
+}
+
+void sensors_poll_context_t::kick(int index)
+{
+    // let pollEvents() read this driver even if its fd is quiet,
+    // it may have queued events of its own (flush complete, ...)
+    __atomic_or_fetch(&mKick, 1u << index, __ATOMIC_RELEASE);
+    int result = poll_engine_wake(&mPoll);
+    ALOGE_IF(result < 0, "error sending wake message (%s)", strerror(-result));
 }
 
 int sensors_poll_context_t::activate(int handle, int enabled)
@@ -361,11 +355,8 @@ int sensors_poll_context_t::realActivate(int handle, int enabled)
         return index;
 
     int err = mSensors[index]->enable(handle, enabled);
-    if (enabled && !err) {
-        const char wakeMessage(WAKE_MESSAGE);
-        int result = write(mWritePipeFd, &wakeMessage, 1);
-        ALOGE_IF(result < 0, "error sending wake message (%s)", strerror(errno));
-    }
+    if (enabled && !err)
+        kick(index);
 
     return err;
 }
@@ -380,8 +371,11 @@ int sensors_poll_context_t::setDelay(int handle, int64_t ns)
 
     if (handle == ID_A)
         mAccelDelay = ns;
-    else if (handle == ID_O)
+    else if (handle == ID_O) {
         mOriDelay = ns;
+        // Feed the AKM driver only as fast as orientation is consumed
+        mSensors[accel]->setDelay(ID_O, ns);
+    }
 
     // Choose the fastest between accelerometer and orientation
     if (handle == ID_O) {
@@ -420,43 +414,45 @@ int sensors_poll_context_t::pollEvents(sensors_event_t* data, int count)
     int n = 0;
 
     do {
-        // see if we have some leftover from the last poll()
-        for (int i = 0; count && i < numSensorDrivers; i++) {
-            SensorBase* const sensor(mSensors[i]);
-            if ((mPollFds[i].revents & POLLIN) || (sensor->hasPendingEvents())) {
-                int nb = sensor->readEvents(data, count);
-                if (nb < count) {
-                    // no more data for this sensor
-                    mPollFds[i].revents = 0;
-                }
-                count -= nb;
-                nbEvents += nb;
-                data += nb;
+        if (mReady & POLL_ENGINE_WAKE) {
+            mReady &= ~POLL_ENGINE_WAKE;
+            mReady |= __atomic_exchange_n(&mKick, 0, __ATOMIC_ACQUIRE);
+        }
+
+        // only visit drivers known to have data, and start from a different
+        // one each round so a busy sensor can't starve the others
+        int first = mNextDriver;
+        mNextDriver = (mNextDriver + 1) % numSensorDrivers;
+        for (int k = 0; count && mReady && k < numSensorDrivers; k++) {
+            int i = (first + k) % numSensorDrivers;
+            if (!(mReady & (1u << i)))
+                continue;
+
+            int budget = count < DRIVER_EVENT_BUDGET ? count : DRIVER_EVENT_BUDGET;
+            int nb = mSensors[i]->readEvents(data, budget);
+            if (nb < budget && !mSensors[i]->hasPendingEvents()) {
+                // no more data for this sensor
+                mReady &= ~(1u << i);
             }
+            if (nb <= 0)
+                continue;
+            count -= nb;
+            nbEvents += nb;
+            data += nb;
         }
 
         if (count) {
             // we still have some room, so try to see if we can get
             // some events immediately or just wait if we don't have
             // anything to return
-            do {
-                n = poll(mPollFds, numFds, nbEvents ? 0 : -1);
-            } while (n < 0 && errno == EINTR);
+            n = poll_engine_wait(&mPoll, &mReady, (nbEvents || mReady) ? 0 : -1);
             if (n < 0) {
-                ALOGE("poll() failed (%s)", strerror(errno));
-                return -errno;
-            }
-            if (mPollFds[wake].revents & POLLIN) {
-                char msg;
-                int result = read(mPollFds[wake].fd, &msg, 1);
-                ALOGE_IF(result < 0, "error reading from wake pipe (%s)", strerror(errno));
-                ALOGE_IF(msg != WAKE_MESSAGE, "unknown message on wake queue (0x%02x)", int(msg));
-
-                mPollFds[wake].revents = 0;
+                ALOGE("epoll_wait() failed (%s)", strerror(-n));
+                return n;
             }
         }
         // if we have events and space, go read them
-    } while (n && count);
+    } while ((n || mReady) && count);
 
     return nbEvents;
 }
@@ -479,7 +475,11 @@ int sensors_poll_context_t::flush(int handle)
     if (index < 0)
         return index;
 
-    return mSensors[index]->flush(handle);
+    int err = mSensors[index]->flush(handle);
+    if (!err)
+        kick(index);
+
+    return err;
 }
 
 /*****************************************************************************/